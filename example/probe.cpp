@@ -0,0 +1,323 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "ksmaxis/ksmaxis.hpp"
+
+namespace
+{
+	constexpr const char* kAxisNames[] = { "X", "Y", "Slider0", "Slider1" };
+
+	std::atomic<bool> s_stopRequested{ false };
+
+	struct Options
+	{
+		double durationSec = 0.0; // 0: until Ctrl+C
+		std::uint32_t refreshMs = 1000;
+		std::string jsonPath;
+	};
+
+	void PrintUsage()
+	{
+		std::cerr << "Usage: ksmaxis_probe [--duration <sec>] [--refresh <ms>] [--json <path>]\n"
+		          << "  --duration <sec>  Stop after this many seconds (default: run until Ctrl+C)\n"
+		          << "  --refresh <ms>    Live report interval (default: 1000)\n"
+		          << "  --json <path>     Write a JSON summary of all devices on exit\n";
+	}
+
+	bool ParseOptions(int argc, char* argv[], Options& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view arg = argv[i];
+			const bool hasValue = i + 1 < argc;
+			if (arg == "--duration" && hasValue)
+			{
+				options.durationSec = std::atof(argv[++i]);
+			}
+			else if (arg == "--refresh" && hasValue)
+			{
+				options.refreshMs = static_cast<std::uint32_t>((std::max)(1, std::atoi(argv[++i])));
+			}
+			else if (arg == "--json" && hasValue)
+			{
+				options.jsonPath = argv[++i];
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string FormatId(std::uint16_t id)
+	{
+		char buffer[8];
+		std::snprintf(buffer, sizeof(buffer), "%04x", id);
+		return buffer;
+	}
+
+	void PrintDeviceList(const std::vector<ksmaxis::DeviceInfo>& devices)
+	{
+		std::cout << devices.size() << " device(s)\n";
+		for (const auto& device : devices)
+		{
+			std::cout << "  " << device.path << " [" << device.backend << "] " << FormatId(device.vendorId) << ":" << FormatId(device.productId)
+			          << " \"" << device.name << "\"\n";
+			for (std::size_t i = 0; i < device.axes.size(); ++i)
+			{
+				const auto& axis = device.axes[i];
+				std::cout << "    " << std::left << std::setw(8) << kAxisNames[i] << std::right;
+				if (axis.available)
+				{
+					std::cout << axis.min << " ~ " << axis.max << "\n";
+				}
+				else
+				{
+					std::cout << "-\n";
+				}
+			}
+			for (const auto& suppressedPath : device.suppressedPaths)
+			{
+				std::cout << "    suppressed sibling " << suppressedPath << "\n";
+			}
+		}
+		std::cout << std::endl;
+	}
+
+	void PrintLiveStats(const std::vector<ksmaxis::DeviceInfo>& devices, std::map<std::string, std::uint64_t>& prevReportCounts, double elapsedSec)
+	{
+		for (const auto& device : devices)
+		{
+			const auto& stats = device.stats;
+			const std::uint64_t prevCount = prevReportCounts[device.path];
+			const double windowRate = elapsedSec > 0.0 ? static_cast<double>(stats.reportCount - prevCount) / elapsedSec : 0.0;
+			prevReportCounts[device.path] = stats.reportCount;
+
+			std::cout << std::fixed << std::setprecision(1)
+			          << std::left << std::setw(20) << device.path << std::right
+			          << " rate " << std::setw(7) << windowRate << " Hz"
+			          << " | interval " << std::setw(8) << stats.intervalMeanUs << " us"
+			          << " jitter " << std::setw(7) << stats.intervalStdDevUs << " us"
+			          << " | latency ";
+			if (stats.hasLatency)
+			{
+				std::cout << std::setw(7) << stats.latencyMeanUs << " us (max " << stats.latencyMaxUs << ")";
+			}
+			else
+			{
+				std::cout << "n/a";
+			}
+			std::cout << " | dropped " << stats.droppedCount << "\n";
+		}
+		std::cout << std::flush;
+	}
+
+	std::string EscapeJson(const std::string& str)
+	{
+		std::string result;
+		for (char c : str)
+		{
+			switch (c)
+			{
+			case '"': result += "\\\""; break;
+			case '\\': result += "\\\\"; break;
+			case '\n': result += "\\n"; break;
+			case '\t': result += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+				{
+					char buffer[8];
+					std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned char>(c));
+					result += buffer;
+				}
+				else
+				{
+					result += c;
+				}
+				break;
+			}
+		}
+		return result;
+	}
+
+	bool WriteJsonSummary(const std::string& path, const std::vector<ksmaxis::DeviceInfo>& devices, double durationSec)
+	{
+		std::ofstream ofs(path);
+		if (!ofs)
+		{
+			return false;
+		}
+
+		ofs << std::fixed << std::setprecision(3);
+		ofs << "{\n  \"durationSec\": " << durationSec << ",\n  \"devices\": [";
+		for (std::size_t i = 0; i < devices.size(); ++i)
+		{
+			const auto& device = devices[i];
+			const auto& stats = device.stats;
+			ofs << (i == 0 ? "\n" : ",\n")
+			    << "    {\n"
+			    << "      \"name\": \"" << EscapeJson(device.name) << "\",\n"
+			    << "      \"path\": \"" << EscapeJson(device.path) << "\",\n"
+			    << "      \"backend\": \"" << EscapeJson(device.backend) << "\",\n"
+			    << "      \"vendorId\": \"" << FormatId(device.vendorId) << "\",\n"
+			    << "      \"productId\": \"" << FormatId(device.productId) << "\",\n"
+			    << "      \"axes\": {";
+			for (std::size_t a = 0; a < device.axes.size(); ++a)
+			{
+				const auto& axis = device.axes[a];
+				ofs << (a == 0 ? " " : ", ") << "\"" << kAxisNames[a] << "\": ";
+				if (axis.available)
+				{
+					ofs << "{ \"min\": " << axis.min << ", \"max\": " << axis.max << " }";
+				}
+				else
+				{
+					ofs << "null";
+				}
+			}
+			ofs << " },\n"
+			    << "      \"suppressedPaths\": [";
+			for (std::size_t p = 0; p < device.suppressedPaths.size(); ++p)
+			{
+				ofs << (p == 0 ? " " : ", ") << "\"" << EscapeJson(device.suppressedPaths[p]) << "\"";
+			}
+			ofs << (device.suppressedPaths.empty() ? "],\n" : " ],\n")
+			    << "      \"reportCount\": " << stats.reportCount << ",\n"
+			    << "      \"eventCount\": " << stats.eventCount << ",\n"
+			    << "      \"droppedCount\": " << stats.droppedCount << ",\n"
+			    << "      \"reportRateHz\": " << stats.reportRateHz << ",\n"
+			    << "      \"intervalMeanUs\": " << stats.intervalMeanUs << ",\n"
+			    << "      \"intervalStdDevUs\": " << stats.intervalStdDevUs << ",\n"
+			    << "      \"intervalMinUs\": " << stats.intervalMinUs << ",\n"
+			    << "      \"intervalMaxUs\": " << stats.intervalMaxUs << ",\n";
+			if (stats.hasLatency)
+			{
+				ofs << "      \"latencyMeanUs\": " << stats.latencyMeanUs << ",\n"
+				    << "      \"latencyMaxUs\": " << stats.latencyMaxUs << "\n";
+			}
+			else
+			{
+				ofs << "      \"latencyMeanUs\": null,\n"
+				    << "      \"latencyMaxUs\": null\n";
+			}
+			ofs << "    }";
+		}
+		ofs << (devices.empty() ? "]\n}\n" : "\n  ]\n}\n");
+		return static_cast<bool>(ofs);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef _WIN32
+	SetConsoleOutputCP(CP_UTF8);
+#endif
+
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	std::signal(SIGINT, [](int)
+	{
+		s_stopRequested = true;
+	});
+
+	ksmaxis::Context context;
+	std::string errorString;
+	std::vector<std::string> warningStrings;
+#ifdef _WIN32
+	const bool initialized = context.Init(ksmaxis::DeviceFlags::Joystick, nullptr, &errorString, &warningStrings);
+#else
+	const bool initialized = context.Init(ksmaxis::DeviceFlags::Joystick, &errorString, &warningStrings);
+#endif
+	for (const auto& warning : warningStrings)
+	{
+		std::cerr << "Warning: " << warning << std::endl;
+	}
+	if (!initialized)
+	{
+		std::cerr << "Init failed: " << errorString << std::endl;
+		return 1;
+	}
+
+	PrintDeviceList(context.GetDevices());
+
+	// Report stats only from the start of the run
+	context.Update();
+	context.ResetDeviceStats();
+	context.ResetUpdateStats();
+
+	// Wake on input so that reads (and thus latency figures) aren't quantized to a frame
+	ksmaxis::CapturePolicy policy;
+	policy.activeSpinUs = 0;
+	context.SetCapturePolicy(policy);
+
+	using Clock = std::chrono::steady_clock;
+	const auto startTime = Clock::now();
+	auto lastRefreshTime = startTime;
+	std::map<std::string, std::uint64_t> prevReportCounts;
+
+	while (!s_stopRequested)
+	{
+		const auto now = Clock::now();
+		const double runSec = std::chrono::duration<double>(now - startTime).count();
+		if (options.durationSec > 0.0 && runSec >= options.durationSec)
+		{
+			break;
+		}
+
+		const double sinceRefreshSec = std::chrono::duration<double>(now - lastRefreshTime).count();
+		if (sinceRefreshSec * 1000.0 >= options.refreshMs)
+		{
+			PrintLiveStats(context.GetDevices(), prevReportCounts, sinceRefreshSec);
+			lastRefreshTime = now;
+		}
+
+		context.WaitForInput(10);
+		context.Update();
+	}
+
+	const double durationSec = std::chrono::duration<double>(Clock::now() - startTime).count();
+	const auto devices = context.GetDevices();
+	std::cout << "\nSummary after " << std::fixed << std::setprecision(1) << durationSec << " s\n";
+	for (const auto& device : devices)
+	{
+		std::cout << "  " << device.path << ": " << device.stats.reportCount << " reports, " << device.stats.reportRateHz << " Hz, jitter "
+		          << device.stats.intervalStdDevUs << " us, dropped " << device.stats.droppedCount << "\n";
+	}
+
+	const ksmaxis::UpdateStats updateStats = context.GetUpdateStats();
+	std::cout << "  Update(): " << updateStats.updateCount << " calls, " << updateStats.ewmaUpdateNs / 1000.0 << " us (EWMA), max "
+	          << updateStats.maxUpdateNs / 1000.0 << " us, " << updateStats.syscallCount << " syscalls, " << updateStats.eventCount << " events\n";
+
+	if (!options.jsonPath.empty())
+	{
+		if (!WriteJsonSummary(options.jsonPath, devices, durationSec))
+		{
+			std::cerr << "Failed to write " << options.jsonPath << std::endl;
+			return 1;
+		}
+		std::cout << "Wrote " << options.jsonPath << std::endl;
+	}
+
+	return 0;
+}
@@ -1,6 +1,11 @@
 ﻿#pragma once
+#include <cstddef>
 #include <cstdint>
 #include <array>
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -48,6 +53,537 @@ namespace ksmaxis
 
 	using AxisValues = std::array<double, 2>;
 
+	constexpr std::size_t kInputModeCount = 3;
+
+	// Bit of a mode in the mask returned by Context::GetChangedModes()
+	constexpr std::uint32_t InputModeBit(InputMode mode) noexcept
+	{
+		return 1U << static_cast<std::uint32_t>(mode);
+	}
+
+	// A consumer's read position over the cumulative axis totals (see Context::ReadCursor())
+	struct AxisCursor
+	{
+		// GetAxisTotals() as of the last read, indexed by InputMode
+		std::array<AxisValues, kInputModeCount> positions{};
+	};
+
+	enum class CaptureState : std::uint8_t
+	{
+		kActive, // Knobs moved within CapturePolicy::idleTimeoutMs
+		kIdle,
+	};
+
+	// Trades CPU for latency depending on whether the knobs are in use
+	struct CapturePolicy
+	{
+		// Switches to idle after this long without axis movement
+		std::uint32_t idleTimeoutMs = 5000;
+
+		// While active, WaitForInput() busy-polls this long before blocking (0: always block)
+		std::uint32_t activeSpinUs = 500;
+
+		// Hotplug rescan interval (Linux; other platforms get hotplug notifications)
+		std::uint32_t activeRescanIntervalMs = 1000;
+		std::uint32_t idleRescanIntervalMs = 5000;
+
+		// Fills CaptureStats::activeCpuTimeNs/idleCpuTimeNs. Costs two thread CPU clock reads per Update(),
+		// LatchLateInput() and WaitForInput(), so it is off by default.
+		bool measureCpuTime = false;
+	};
+
+	struct CaptureStats
+	{
+		// Returns from WaitForInput(), including timeouts
+		std::uint64_t activeWakeups = 0;
+		std::uint64_t idleWakeups = 0;
+
+		// Thread CPU time spent inside Update() and WaitForInput() (only with CapturePolicy::measureCpuTime)
+		std::uint64_t activeCpuTimeNs = 0;
+		std::uint64_t idleCpuTimeNs = 0;
+
+		std::uint64_t activeToIdleCount = 0;
+		std::uint64_t idleToActiveCount = 0;
+	};
+
+	// Caps the work of one Update() call (0: unlimited). Input left over when a limit is hit stays queued
+	// (in the kernel, Xlib or DirectInput) and is read by the next Update().
+	struct UpdateBudget
+	{
+		std::uint32_t maxDurationUs = 0;
+		std::uint32_t maxEvents = 0; // Counted like DeviceStats::eventCount, plus X11 events and raw mouse input
+	};
+
+	enum class ResponseCurveType : std::uint8_t
+	{
+		kLinear,
+		kPower, // inputMax * (x / inputMax) ^ exponent
+		kPiecewise, // Linear between points
+		kCustom, // function
+	};
+
+	// Maps the magnitude of each axis delta of one Update() to a new magnitude, keeping its sign
+	// (e.g. deadzone, sensitivity and acceleration). See Context::SetResponseCurve().
+	struct ResponseCurve
+	{
+		ResponseCurveType type = ResponseCurveType::kLinear;
+
+		// Range of |delta| the curve is defined over. Larger deltas continue along its last segment.
+		double inputMax = 1.0;
+
+		// |delta| up to this becomes 0; the curve is stretched over (deadzone, inputMax]
+		double deadzone = 0.0;
+
+		double sensitivity = 1.0; // Output multiplier
+		double exponent = 1.0; // kPower
+
+		// kPiecewise: (input, output) pairs in ascending input order, covering [0, inputMax]
+		std::vector<std::array<double, 2>> points;
+
+		// kCustom: output for an input in [0, inputMax]. Only sampled when the curve is compiled.
+		std::function<double(double)> function;
+	};
+
+	// A response curve compiled into a lookup table, applied with one interpolation per axis
+	struct ResponseCurveTable
+	{
+		static constexpr std::size_t kSize = 257;
+
+		double inputMax = 1.0;
+
+		// Output for |delta| = i * inputMax / (kSize - 1)
+		std::array<double, kSize> values{};
+
+		[[nodiscard]]
+		constexpr double Apply(double delta) const noexcept
+		{
+			const bool negative = delta < 0.0;
+			const double position = (negative ? -delta : delta) / inputMax * static_cast<double>(kSize - 1);
+			std::size_t index = kSize - 2;
+			if (position < static_cast<double>(kSize - 1))
+			{
+				index = static_cast<std::size_t>(position);
+			}
+			const double fraction = position - static_cast<double>(index);
+			const double magnitude = values[index] + (values[index + 1] - values[index]) * fraction;
+			return negative ? -magnitude : magnitude;
+		}
+	};
+
+	enum class ResponseCurvePreset : std::uint8_t
+	{
+		kLinear,
+		kQuadratic, // Fine control at low speed, fast at high speed
+		kCubic,
+		kSmoothStep, // Slow start and end (3t^2 - 2t^3)
+	};
+
+	// Built-in curves, so that a table can be generated at compile time
+	[[nodiscard]]
+	constexpr ResponseCurveTable MakeResponseCurveTable(ResponseCurvePreset preset, double inputMax = 1.0, double sensitivity = 1.0) noexcept
+	{
+		ResponseCurveTable table;
+		table.inputMax = inputMax;
+		for (std::size_t i = 0; i < ResponseCurveTable::kSize; ++i)
+		{
+			const double t = static_cast<double>(i) / static_cast<double>(ResponseCurveTable::kSize - 1);
+			double shaped = t;
+			switch (preset)
+			{
+			case ResponseCurvePreset::kQuadratic:
+				shaped = t * t;
+				break;
+			case ResponseCurvePreset::kCubic:
+				shaped = t * t * t;
+				break;
+			case ResponseCurvePreset::kSmoothStep:
+				shaped = t * t * (3.0 - 2.0 * t);
+				break;
+			default:
+				break;
+			}
+			table.values[i] = shaped * inputMax * sensitivity;
+		}
+		return table;
+	}
+
+	// Samples a curve into a table. Fails if inputMax isn't positive, the deadzone isn't below it, or kPiecewise
+	// points aren't ascending or kCustom has no function.
+	bool CompileResponseCurve(const ResponseCurve& curve, ResponseCurveTable& table, std::string* pErrorString = nullptr);
+
+	struct DeviceAxisInfo
+	{
+		bool available = false;
+		std::int32_t min = 0;
+		std::int32_t max = 0;
+	};
+
+	// Report timing since the device was opened or ResetDeviceStats()
+	struct DeviceStats
+	{
+		std::uint64_t reportCount = 0;
+		std::uint64_t eventCount = 0; // Input events processed (evdev events, hidraw reports, DirectInput records, IOKit values)
+		std::uint64_t droppedCount = 0; // Lost to a full kernel/driver buffer (evdev SYN_DROPPED, DirectInput overflow)
+
+		double reportRateHz = 0.0;
+
+		// Interval between consecutive reports, from device timestamps where the backend has them
+		double intervalMeanUs = 0.0;
+		double intervalStdDevUs = 0.0; // Jitter
+		double intervalMinUs = 0.0;
+		double intervalMaxUs = 0.0;
+
+		// Report timestamp to read by the library (false for hidraw, which has no timestamps)
+		bool hasLatency = false;
+		double latencyMeanUs = 0.0;
+		double latencyMaxUs = 0.0;
+	};
+
+	// Counts of DeviceStats kept in atomics, so that a monitoring thread can read them while another thread calls
+	// Update() (see Context::GetDeviceCounters())
+	struct DeviceCounters
+	{
+		std::uint32_t deviceId = 0; // See DeviceInfo::id
+		std::uint64_t reportCount = 0;
+		std::uint64_t eventCount = 0;
+		std::uint64_t droppedCount = 0;
+	};
+
+	struct DeviceInfo
+	{
+		std::uint32_t id = 0; // Unique among the devices opened by the context (not kept across replugs)
+		std::string name;
+		std::string path;
+		std::string backend; // e.g. "evdev", "hidraw", "DirectInput", "IOKit"
+		std::uint16_t vendorId = 0;
+		std::uint16_t productId = 0;
+
+		// Raw ranges of X, Y, Slider0 and Slider1 (the axes behind kAnalogStick and kSlider)
+		std::array<DeviceAxisInfo, 4> axes{};
+
+		DeviceStats stats;
+
+		bool grabbed = false; // Read exclusively (Linux evdev, see Context::SetExclusiveGrab())
+
+		// Sibling interfaces of the same physical device left closed in favor of this one, so that their
+		// axes aren't read (and counted) twice (Linux evdev)
+		std::vector<std::string> suppressedPaths;
+	};
+
+	// Always-on counters of the library's hot paths since the context was created or ResetUpdateStats()
+	struct UpdateStats
+	{
+		std::uint64_t updateCount = 0;
+
+		// Wall time of Update()
+		std::uint64_t lastUpdateNs = 0;
+		std::uint64_t ewmaUpdateNs = 0; // Exponentially weighted moving average (newest sample weighted 1/16)
+		std::uint64_t maxUpdateNs = 0;
+
+		// Syscalls made by the library on Linux: reads, polls, hotplug rescans and device setup, as well as the
+		// thread CPU clock reads of CapturePolicy::measureCpuTime. Syscalls Xlib and libwayland make internally
+		// are not included. Windows counts DirectInput Poll()/GetDeviceData()/GetDeviceState() calls and macOS
+		// counts run loop passes instead, plus the thread CPU clock reads on both.
+		std::uint64_t syscallCount = 0;
+
+		std::uint64_t eventCount = 0; // Sum over devices (see DeviceStats::eventCount)
+		std::uint64_t rescanCount = 0; // Hotplug rescans (Linux)
+		std::uint64_t x11EventCount = 0; // X11 events drained for DeviceFlags::Mouse (Linux)
+		std::uint64_t waylandEventCount = 0; // Wayland events dispatched for DeviceFlags::Mouse (Linux, see SetWaylandSurface())
+		std::uint64_t truncatedUpdateCount = 0; // Update() calls stopped by the UpdateBudget
+	};
+
+#ifdef __linux__
+	// Maps an input field of a HID report descriptor to a knob axis for the hidraw backend
+	struct HidrawAxisMapping
+	{
+		std::uint16_t vendorId = 0;
+		std::uint16_t productId = 0;
+		std::uint16_t usagePage = 0; // e.g. 0x01 (Generic Desktop) or 0xFF00~0xFFFF (vendor-defined)
+		std::uint16_t usage = 0;
+		InputMode mode = InputMode::kSlider; // kAnalogStick or kSlider
+		std::uint8_t axisIndex = 0; // 0 or 1
+	};
+
+	// Real-time settings for the thread that calls Update() and WaitForInput(), see Context::SetRealtimeCapture()
+	struct RealtimeCaptureConfig
+	{
+		int fifoPriority = 0; // SCHED_FIFO priority (1~99); 0 leaves the scheduling class unchanged
+		std::vector<int> cpus; // CPUs the thread is pinned to; empty leaves the affinity unchanged
+		// mlock() the context object, which holds the device, queue and tick storage inline. Heap memory it points
+		// to (configuration lists, coroutine waiters, Xlib and libwayland buffers) is not locked; use mlockall() to
+		// pin the whole process instead.
+		bool lockMemory = false;
+	};
+
+#endif
+
+	namespace detail
+	{
+		struct ContextImpl;
+	}
+
+	class Context;
+
+	// Returned by Context::NextInput()
+	class InputAwaitable
+	{
+	public:
+		explicit InputAwaitable(Context& context) noexcept
+			: m_context(context)
+		{
+		}
+
+		[[nodiscard]]
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle);
+
+		void await_resume() const noexcept
+		{
+		}
+
+	private:
+		Context& m_context;
+	};
+
+	// Owns devices, backends and delta state. Independent contexts share no mutable state,
+	// so each can be driven from its own thread (e.g. one per player station).
+	class Context
+	{
+	public:
+		Context();
+
+		~Context();
+
+		Context(const Context&) = delete;
+
+		Context& operator=(const Context&) = delete;
+
+#ifdef _WIN32
+		// Raw mouse input is delivered to one context per process (last one initialized with DeviceFlags::Mouse)
+		bool Init(DeviceFlags deviceFlags, void* hWnd, std::string* pErrorString = nullptr, std::vector<std::string>* pWarningStrings = nullptr);
+#else
+		bool Init(DeviceFlags deviceFlags, std::string* pErrorString = nullptr, std::vector<std::string>* pWarningStrings = nullptr);
+#endif
+
+		void Terminate();
+
+		// Declares the InputModes the application reads (all by default). Devices requested by Init() that no
+		// active mode needs (see GetRequiredDeviceFlags()) stay closed until a mode needs them, and the deltas
+		// of inactive modes are not computed. IsInitialized() reports the devices that are actually open.
+		void SetActiveInputModes(const std::vector<InputMode>& modes, std::vector<std::string>* pWarningStrings = nullptr);
+
+		[[nodiscard]]
+		bool IsInputModeActive(InputMode mode) const;
+
+		[[nodiscard]]
+		bool IsInitialized() const;
+
+		[[nodiscard]]
+		bool IsInitialized(DeviceFlags deviceFlags) const;
+
+		// Performs no heap allocations of its own once initialized, including the periodic hotplug rescan on Linux.
+		// Platform APIs may still allocate internally (e.g. Xlib when delivering XInput2 events for DeviceFlags::Mouse).
+		void Update();
+
+		[[nodiscard]]
+		AxisValues GetAxisDeltas(InputMode mode) const;
+
+		// Drains only the input that arrived since Update(), e.g. right before render submission, without the
+		// rescan, and without resetting GetAxisDeltas(). Its deltas (summed over the calls since Update()) are
+		// reported separately by GetLateAxisDeltas() and left out of the next Update(). They count towards the
+		// totals, cursors, changed modes and change generations, but not the tick deltas. With a response curve,
+		// the curve is applied to the whole raw delta of the frame and the late deltas are what that adds to the
+		// deltas of Update(), so the two sum to the same value as without the latch.
+		void LatchLateInput();
+
+		[[nodiscard]]
+		AxisValues GetLateAxisDeltas(InputMode mode) const;
+
+		// Sum of every delta reported by Update() since the context was created (not reset by Terminate())
+		[[nodiscard]]
+		AxisValues GetAxisTotals(InputMode mode) const;
+
+		// InputModeBit() of each mode whose delta from the last Update() is non-zero (0 when nothing moved)
+		[[nodiscard]]
+		std::uint32_t GetChangedModes() const;
+
+		// Number of Update() calls so far that changed any mode, or the given mode. Consumers can keep the value they
+		// last processed and skip their work with one compare while it's unchanged.
+		[[nodiscard]]
+		std::uint64_t GetChangeGeneration() const;
+
+		[[nodiscard]]
+		std::uint64_t GetChangeGeneration(InputMode mode) const;
+
+		// Shapes each axis delta of the mode in Update(), before GetAxisDeltas(), the totals, cursors and ticks see
+		// it. Curves are compiled here, so Update() only interpolates a table. Fails (keeping the previous curve)
+		// if CompileResponseCurve() does.
+		bool SetResponseCurve(InputMode mode, const ResponseCurve& curve, std::string* pErrorString = nullptr);
+
+		// Uses a precompiled table, e.g. one made by MakeResponseCurveTable()
+		void SetResponseCurve(InputMode mode, const ResponseCurveTable& table);
+
+		void ClearResponseCurve(InputMode mode);
+
+		// Splits each Update()'s deltas into fixed ticks of tickUs on a monotonic grid, binned by report timestamp,
+		// for fixed-timestep simulations. 0 (default) disables tick output. Knob reports carry timestamps on every
+		// platform (Windows: buffered DirectInput records; macOS: values dispatched by Update()); the mouse only on
+		// Linux. Raw Input and IOHID mouse deltas, and the resyncs after lost DirectInput data, are untimestamped.
+		void SetTickInterval(std::uint32_t tickUs);
+
+		// Deltas of each tick boundary crossed during the last Update(), oldest first. Input timestamped past the
+		// last boundary (or with no timestamp) lands in the last tick, so the ticks always sum to GetAxisDeltas()
+		// plus any input carried over from Updates that crossed no boundary. Valid until the next Update().
+		[[nodiscard]]
+		std::span<const AxisValues> GetTickDeltas(InputMode mode) const;
+
+		// std::chrono::steady_clock time (CLOCK_MONOTONIC on Linux) in ns of the first tick returned by
+		// GetTickDeltas(); each following tick is one tick interval later
+		[[nodiscard]]
+		std::int64_t GetFirstTickTimeNs() const;
+
+		// Cursors let any number of consumers (e.g. gameplay, UI and a replay recorder) read the deltas since
+		// their own last read, at their own cadence, without draining devices again. A new cursor starts at the
+		// current totals. Cursors are plain values read on the Update() thread.
+		[[nodiscard]]
+		AxisCursor CreateCursor() const;
+
+		// Returns the delta since the cursor last read this mode, and advances the cursor
+		AxisValues ReadCursor(AxisCursor& cursor, InputMode mode) const;
+
+		// Bounds the time spent in a single Update() after a stall or with a chattering device. Devices are
+		// drained round-robin across truncated calls, so one busy device can't starve the others. Ignored on macOS,
+		// where IOHID delivers values through callbacks that can't be deferred; each Update() services a single
+		// run loop source there instead.
+		void SetUpdateBudget(const UpdateBudget& budget);
+
+		[[nodiscard]]
+		UpdateBudget GetUpdateBudget() const;
+
+		// Whether the last Update() hit the budget; input may still be queued, so call Update() again when
+		// the frame has time left. The poll fd does not report input that Xlib has already read off the connection.
+		// Always false on macOS (see SetUpdateBudget()).
+		[[nodiscard]]
+		bool WasUpdateTruncated() const;
+
+		// Blocks until an initialized device has pending input or timeoutMs elapses. Returns false on timeout.
+		// Call Update() afterwards; the active/idle state is re-evaluated there.
+		bool WaitForInput(std::uint32_t timeoutMs);
+
+#ifdef __linux__
+		// An epoll fd that is readable while an initialized device has pending input; register it with an
+		// event loop and call Update() when it fires. It stays valid (and tracks hotplug, Init() and Terminate())
+		// until the context is destroyed. Input that moves no axis (e.g. buttons) also makes it readable.
+		// Returns -1 on failure.
+		[[nodiscard]]
+		int GetPollFd();
+#endif
+
+#ifdef _WIN32
+		// An auto-reset event signaled when a joystick has pending input, or nullptr if none is open.
+		// Raw mouse input arrives as WM_INPUT on the message queue instead. Changes on Init(), Terminate()
+		// and SetActiveInputModes().
+		[[nodiscard]]
+		void* GetWaitHandle() const;
+#endif
+
+		// co_await NextInput() suspends until an Update() call produces a non-zero delta for an active mode,
+		// and resumes the coroutine at the end of that call, so GetAxisDeltas() returns its deltas.
+		// The coroutine runs on the thread calling Update(); pair with GetPollFd() to avoid polling.
+		[[nodiscard]]
+		InputAwaitable NextInput() noexcept;
+
+		void SetCapturePolicy(const CapturePolicy& policy);
+
+		[[nodiscard]]
+		CapturePolicy GetCapturePolicy() const;
+
+		[[nodiscard]]
+		CaptureState GetCaptureState() const;
+
+		[[nodiscard]]
+		CaptureStats GetCaptureStats() const;
+
+		void ResetCaptureStats();
+
+		// Joystick devices currently open, with their capabilities and report timing (allocates; meant for diagnostics)
+		[[nodiscard]]
+		std::vector<DeviceInfo> GetDevices() const;
+
+		void ResetDeviceStats();
+
+		// Unlike the other getters, these two may be called from any thread while another thread calls Update()
+		[[nodiscard]]
+		UpdateStats GetUpdateStats() const;
+
+		void ResetUpdateStats();
+
+		// Fills counters with the live counts of the open devices and returns how many were written. Doesn't
+		// allocate and, like GetUpdateStats(), may be called from any thread.
+		std::size_t GetDeviceCounters(std::span<DeviceCounters> counters) const;
+
+#ifdef __linux__
+		// Devices matching these mappings are read from /dev/hidraw* instead of evdev, at the full resolution
+		// of the report field. Set before Init(DeviceFlags::Joystick); an empty list disables the hidraw backend.
+		void SetHidrawAxisMappings(const std::vector<HidrawAxisMapping>& mappings);
+
+		// Reads DeviceFlags::Mouse only from these XInput2 slave pointers, given by name or decimal device id
+		// (as listed by `xinput list`). RawMotion is selected on the X server per device, so other pointers such as
+		// touchpads don't wake the library. Plugged-in matches are picked up automatically. An empty list (default)
+		// follows all master pointers. Takes effect immediately if the mouse backend is open.
+		void SetX11MouseDevices(const std::vector<std::string>& devices);
+
+		// Grabs the evdev knob devices the library opens (EVIOCGRAB), now and on later hotplug, so that libinput,
+		// the compositor and X no longer see their events (e.g. as stray pointer or scroll input). The kernel
+		// releases a grab when the device is closed by Terminate() or the process exits. Returns false if a device
+		// could not be grabbed (e.g. another process holds it); it is still read. Devices read through hidraw
+		// are not grabbed.
+		bool SetExclusiveGrab(bool enabled);
+
+		// Applied by the next Init() to the calling thread, which should be the one that calls Update() and
+		// WaitForInput() (the library has no threads of its own). Settings that fail (e.g. without CAP_SYS_NICE,
+		// RLIMIT_RTPRIO or RLIMIT_MEMLOCK) are reported through pWarningStrings and skipped. The scheduling class
+		// and affinity stay set after Terminate(); the memory lock is released with the context.
+		void SetRealtimeCapture(const RealtimeCaptureConfig& config);
+
+		// Reads DeviceFlags::Mouse as unaccelerated relative pointer motion (zwp_relative_pointer_v1) on this
+		// wl_surface instead of through X11/XWayland. Requires a build with KSMAXIS_LINUX_WAYLAND; falls back to X11
+		// otherwise. The display and surface stay owned by the application. Motion is only delivered while the surface
+		// has pointer focus, so by default the pointer is also locked to it (zwp_pointer_constraints_v1); the
+		// application must not constrain the pointer itself then. The library's events go to a private event queue
+		// dispatched by Update(). Set before Init(DeviceFlags::Mouse); nullptrs (default) select X11.
+		void SetWaylandSurface(void* pDisplay, void* pSurface, bool lockPointer = true);
+#endif
+
+	private:
+		friend class InputAwaitable;
+
+		void AddInputWaiter(std::coroutine_handle<> handle);
+
+		std::unique_ptr<detail::ContextImpl> m_pImpl;
+	};
+
+	// Context used by the free functions below
+	[[nodiscard]]
+	Context& GetDefaultContext();
+
+#ifdef __linux__
+	void SetHidrawAxisMappings(const std::vector<HidrawAxisMapping>& mappings);
+
+	void SetX11MouseDevices(const std::vector<std::string>& devices);
+
+	bool SetExclusiveGrab(bool enabled);
+
+	void SetRealtimeCapture(const RealtimeCaptureConfig& config);
+
+	void SetWaylandSurface(void* pDisplay, void* pSurface, bool lockPointer = true);
+#endif
+
 #ifdef _WIN32
 	bool Init(DeviceFlags deviceFlags, void* hWnd, std::string* pErrorString = nullptr, std::vector<std::string>* pWarningStrings = nullptr);
 #else
@@ -56,6 +592,11 @@ namespace ksmaxis
 
 	void Terminate();
 
+	void SetActiveInputModes(const std::vector<InputMode>& modes, std::vector<std::string>* pWarningStrings = nullptr);
+
+	[[nodiscard]]
+	bool IsInputModeActive(InputMode mode);
+
 	[[nodiscard]]
 	bool IsInitialized();
 
@@ -67,6 +608,95 @@ namespace ksmaxis
 	[[nodiscard]]
 	AxisValues GetAxisDeltas(InputMode mode);
 
+	void LatchLateInput();
+
+	[[nodiscard]]
+	AxisValues GetLateAxisDeltas(InputMode mode);
+
+	[[nodiscard]]
+	AxisValues GetAxisTotals(InputMode mode);
+
+	[[nodiscard]]
+	std::uint32_t GetChangedModes();
+
+	[[nodiscard]]
+	std::uint64_t GetChangeGeneration();
+
+	[[nodiscard]]
+	std::uint64_t GetChangeGeneration(InputMode mode);
+
+	bool SetResponseCurve(InputMode mode, const ResponseCurve& curve, std::string* pErrorString = nullptr);
+
+	void SetResponseCurve(InputMode mode, const ResponseCurveTable& table);
+
+	void ClearResponseCurve(InputMode mode);
+
+	void SetTickInterval(std::uint32_t tickUs);
+
+	[[nodiscard]]
+	std::span<const AxisValues> GetTickDeltas(InputMode mode);
+
+	[[nodiscard]]
+	std::int64_t GetFirstTickTimeNs();
+
+	[[nodiscard]]
+	AxisCursor CreateCursor();
+
+	AxisValues ReadCursor(AxisCursor& cursor, InputMode mode);
+
+	void SetUpdateBudget(const UpdateBudget& budget);
+
+	[[nodiscard]]
+	UpdateBudget GetUpdateBudget();
+
+	[[nodiscard]]
+	bool WasUpdateTruncated();
+
+	bool WaitForInput(std::uint32_t timeoutMs);
+
+#ifdef __linux__
+	[[nodiscard]]
+	int GetPollFd();
+#endif
+
+#ifdef _WIN32
+	[[nodiscard]]
+	void* GetWaitHandle();
+#endif
+
+	[[nodiscard]]
+	InputAwaitable NextInput() noexcept;
+
+	void SetCapturePolicy(const CapturePolicy& policy);
+
+	[[nodiscard]]
+	CapturePolicy GetCapturePolicy();
+
+	[[nodiscard]]
+	CaptureState GetCaptureState();
+
+	[[nodiscard]]
+	CaptureStats GetCaptureStats();
+
+	void ResetCaptureStats();
+
+	[[nodiscard]]
+	std::vector<DeviceInfo> GetDevices();
+
+	void ResetDeviceStats();
+
+	[[nodiscard]]
+	UpdateStats GetUpdateStats();
+
+	void ResetUpdateStats();
+
+	std::size_t GetDeviceCounters(std::span<DeviceCounters> counters);
+
+	// Writes the spans recorded by a KSMAXIS_TRACE build as Chrome trace event JSON (also loadable in Perfetto)
+	bool WriteTrace(const std::string& filePath, std::string* pErrorString = nullptr);
+
+	void ClearTrace();
+
 	[[nodiscard]]
 	constexpr DeviceFlags GetRequiredDeviceFlags(InputMode mode) noexcept
 	{
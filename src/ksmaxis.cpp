@@ -0,0 +1,273 @@
+﻿#include "ksmaxis/ksmaxis.hpp"
+
+namespace ksmaxis
+{
+	void InputAwaitable::await_suspend(std::coroutine_handle<> handle)
+	{
+		m_context.AddInputWaiter(handle);
+	}
+
+	InputAwaitable Context::NextInput() noexcept
+	{
+		return InputAwaitable{ *this };
+	}
+
+	AxisCursor Context::CreateCursor() const
+	{
+		AxisCursor cursor;
+		for (InputMode mode : { InputMode::kAnalogStick, InputMode::kSlider, InputMode::kMouse })
+		{
+			cursor.positions[static_cast<std::size_t>(mode)] = GetAxisTotals(mode);
+		}
+		return cursor;
+	}
+
+	AxisValues Context::ReadCursor(AxisCursor& cursor, InputMode mode) const
+	{
+		const AxisValues totals = GetAxisTotals(mode);
+		AxisValues& position = cursor.positions[static_cast<std::size_t>(mode)];
+		const AxisValues deltas = { totals[0] - position[0], totals[1] - position[1] };
+		position = totals;
+		return deltas;
+	}
+
+	Context& GetDefaultContext()
+	{
+		// Intentionally never destroyed, so Terminate() stays callable from atexit handlers and static destructors
+		static Context* const pDefaultContext = new Context();
+		return *pDefaultContext;
+	}
+
+#ifdef __linux__
+	void SetHidrawAxisMappings(const std::vector<HidrawAxisMapping>& mappings)
+	{
+		GetDefaultContext().SetHidrawAxisMappings(mappings);
+	}
+
+	void SetX11MouseDevices(const std::vector<std::string>& devices)
+	{
+		GetDefaultContext().SetX11MouseDevices(devices);
+	}
+
+	bool SetExclusiveGrab(bool enabled)
+	{
+		return GetDefaultContext().SetExclusiveGrab(enabled);
+	}
+
+	void SetRealtimeCapture(const RealtimeCaptureConfig& config)
+	{
+		GetDefaultContext().SetRealtimeCapture(config);
+	}
+
+	void SetWaylandSurface(void* pDisplay, void* pSurface, bool lockPointer)
+	{
+		GetDefaultContext().SetWaylandSurface(pDisplay, pSurface, lockPointer);
+	}
+#endif
+
+#ifdef _WIN32
+	bool Init(DeviceFlags deviceFlags, void* hWnd, std::string* pErrorString, std::vector<std::string>* pWarningStrings)
+	{
+		return GetDefaultContext().Init(deviceFlags, hWnd, pErrorString, pWarningStrings);
+	}
+#else
+	bool Init(DeviceFlags deviceFlags, std::string* pErrorString, std::vector<std::string>* pWarningStrings)
+	{
+		return GetDefaultContext().Init(deviceFlags, pErrorString, pWarningStrings);
+	}
+#endif
+
+	void Terminate()
+	{
+		GetDefaultContext().Terminate();
+	}
+
+	void SetActiveInputModes(const std::vector<InputMode>& modes, std::vector<std::string>* pWarningStrings)
+	{
+		GetDefaultContext().SetActiveInputModes(modes, pWarningStrings);
+	}
+
+	bool IsInputModeActive(InputMode mode)
+	{
+		return GetDefaultContext().IsInputModeActive(mode);
+	}
+
+	bool IsInitialized()
+	{
+		return GetDefaultContext().IsInitialized();
+	}
+
+	bool IsInitialized(DeviceFlags deviceFlags)
+	{
+		return GetDefaultContext().IsInitialized(deviceFlags);
+	}
+
+	void Update()
+	{
+		GetDefaultContext().Update();
+	}
+
+	AxisValues GetAxisDeltas(InputMode mode)
+	{
+		return GetDefaultContext().GetAxisDeltas(mode);
+	}
+
+	void LatchLateInput()
+	{
+		GetDefaultContext().LatchLateInput();
+	}
+
+	AxisValues GetLateAxisDeltas(InputMode mode)
+	{
+		return GetDefaultContext().GetLateAxisDeltas(mode);
+	}
+
+	AxisValues GetAxisTotals(InputMode mode)
+	{
+		return GetDefaultContext().GetAxisTotals(mode);
+	}
+
+	std::uint32_t GetChangedModes()
+	{
+		return GetDefaultContext().GetChangedModes();
+	}
+
+	std::uint64_t GetChangeGeneration()
+	{
+		return GetDefaultContext().GetChangeGeneration();
+	}
+
+	std::uint64_t GetChangeGeneration(InputMode mode)
+	{
+		return GetDefaultContext().GetChangeGeneration(mode);
+	}
+
+	bool SetResponseCurve(InputMode mode, const ResponseCurve& curve, std::string* pErrorString)
+	{
+		return GetDefaultContext().SetResponseCurve(mode, curve, pErrorString);
+	}
+
+	void SetResponseCurve(InputMode mode, const ResponseCurveTable& table)
+	{
+		GetDefaultContext().SetResponseCurve(mode, table);
+	}
+
+	void ClearResponseCurve(InputMode mode)
+	{
+		GetDefaultContext().ClearResponseCurve(mode);
+	}
+
+	void SetTickInterval(std::uint32_t tickUs)
+	{
+		GetDefaultContext().SetTickInterval(tickUs);
+	}
+
+	std::span<const AxisValues> GetTickDeltas(InputMode mode)
+	{
+		return GetDefaultContext().GetTickDeltas(mode);
+	}
+
+	std::int64_t GetFirstTickTimeNs()
+	{
+		return GetDefaultContext().GetFirstTickTimeNs();
+	}
+
+	AxisCursor CreateCursor()
+	{
+		return GetDefaultContext().CreateCursor();
+	}
+
+	AxisValues ReadCursor(AxisCursor& cursor, InputMode mode)
+	{
+		return GetDefaultContext().ReadCursor(cursor, mode);
+	}
+
+	void SetUpdateBudget(const UpdateBudget& budget)
+	{
+		GetDefaultContext().SetUpdateBudget(budget);
+	}
+
+	UpdateBudget GetUpdateBudget()
+	{
+		return GetDefaultContext().GetUpdateBudget();
+	}
+
+	bool WasUpdateTruncated()
+	{
+		return GetDefaultContext().WasUpdateTruncated();
+	}
+
+	bool WaitForInput(std::uint32_t timeoutMs)
+	{
+		return GetDefaultContext().WaitForInput(timeoutMs);
+	}
+
+#ifdef __linux__
+	int GetPollFd()
+	{
+		return GetDefaultContext().GetPollFd();
+	}
+#endif
+
+#ifdef _WIN32
+	void* GetWaitHandle()
+	{
+		return GetDefaultContext().GetWaitHandle();
+	}
+#endif
+
+	InputAwaitable NextInput() noexcept
+	{
+		return GetDefaultContext().NextInput();
+	}
+
+	void SetCapturePolicy(const CapturePolicy& policy)
+	{
+		GetDefaultContext().SetCapturePolicy(policy);
+	}
+
+	CapturePolicy GetCapturePolicy()
+	{
+		return GetDefaultContext().GetCapturePolicy();
+	}
+
+	CaptureState GetCaptureState()
+	{
+		return GetDefaultContext().GetCaptureState();
+	}
+
+	CaptureStats GetCaptureStats()
+	{
+		return GetDefaultContext().GetCaptureStats();
+	}
+
+	void ResetCaptureStats()
+	{
+		GetDefaultContext().ResetCaptureStats();
+	}
+
+	std::vector<DeviceInfo> GetDevices()
+	{
+		return GetDefaultContext().GetDevices();
+	}
+
+	void ResetDeviceStats()
+	{
+		GetDefaultContext().ResetDeviceStats();
+	}
+
+	UpdateStats GetUpdateStats()
+	{
+		return GetDefaultContext().GetUpdateStats();
+	}
+
+	void ResetUpdateStats()
+	{
+		GetDefaultContext().ResetUpdateStats();
+	}
+
+	std::size_t GetDeviceCounters(std::span<DeviceCounters> counters)
+	{
+		return GetDefaultContext().GetDeviceCounters(counters);
+	}
+}
@@ -0,0 +1,38 @@
+﻿#pragma once
+
+namespace ksmaxis::detail
+{
+	// Wrap-around detection threshold (half of normalized range)
+	inline constexpr double kWrapThreshold = 0.5;
+
+	// Delta between two normalized (0.0~1.0) positions of an endless knob, taking the shorter way around
+	[[nodiscard]]
+	constexpr double CalculateDelta(double current, double prev) noexcept
+	{
+		double delta = current - prev;
+
+		// Wrap-around correction
+		if (delta > kWrapThreshold)
+		{
+			delta -= 1.0;
+		}
+		else if (delta < -kWrapThreshold)
+		{
+			delta += 1.0;
+		}
+
+		return delta;
+	}
+
+	// Applies one reported axis value. Backends call this per hardware report (not per Update()), so that a knob
+	// spun more than half a turn between two Update() calls still sums to its true rotation.
+	constexpr void ApplyAxisValue(double value, double& axis, double& delta, bool active) noexcept
+	{
+		// Inactive axes only track their position, so that enabling the mode later doesn't produce a jump
+		if (active)
+		{
+			delta += CalculateDelta(value, axis);
+		}
+		axis = value;
+	}
+}
@@ -0,0 +1,63 @@
+﻿#pragma once
+#include "ksmaxis/ksmaxis.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+namespace ksmaxis::detail
+{
+	// Tracks the UpdateBudget of one Update() call. Drain loops check IsExhausted() before each read
+	// and leave whatever is still queued for the next call.
+	class UpdateBudgetScope
+	{
+	public:
+		explicit UpdateBudgetScope(const UpdateBudget& budget) noexcept
+			: m_maxEvents(budget.maxEvents)
+			, m_hasDeadline(budget.maxDurationUs > 0)
+			, m_deadline(std::chrono::steady_clock::now() + std::chrono::microseconds{ budget.maxDurationUs })
+		{
+		}
+
+		void AddEvents(std::uint64_t count) noexcept
+		{
+			m_eventCount += count;
+		}
+
+		// Latches, so that every drain loop of the call stops once any limit is hit. The time limit only
+		// applies after the first event, so that each call makes progress even if the rescan used up the budget.
+		[[nodiscard]]
+		bool IsExhausted() noexcept
+		{
+			if (!m_exhausted)
+			{
+				m_exhausted = (m_maxEvents > 0 && m_eventCount >= m_maxEvents) || (m_hasDeadline && m_eventCount > 0 && std::chrono::steady_clock::now() >= m_deadline);
+			}
+			return m_exhausted;
+		}
+
+		// Whether IsExhausted() has returned true, without checking the clock again
+		[[nodiscard]]
+		bool WasExhausted() const noexcept
+		{
+			return m_exhausted;
+		}
+
+		// Events that may still be read (UINT64_MAX if unlimited)
+		[[nodiscard]]
+		std::uint64_t GetRemainingEvents() const noexcept
+		{
+			if (m_maxEvents == 0)
+			{
+				return UINT64_MAX;
+			}
+			return m_eventCount < m_maxEvents ? m_maxEvents - m_eventCount : 0;
+		}
+
+	private:
+		std::uint64_t m_maxEvents;
+		std::uint64_t m_eventCount = 0;
+		bool m_hasDeadline;
+		bool m_exhausted = false;
+		std::chrono::steady_clock::time_point m_deadline;
+	};
+}
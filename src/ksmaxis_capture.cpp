@@ -0,0 +1,145 @@
+﻿#include "ksmaxis_capture.hpp"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace ksmaxis::detail
+{
+	namespace
+	{
+		std::int64_t GetThreadCpuTimeNs() noexcept
+		{
+#ifdef _WIN32
+			FILETIME creationTime, exitTime, kernelTime, userTime;
+			if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+			{
+				return 0;
+			}
+			const auto toNs = [](const FILETIME& time)
+			{
+				return ((static_cast<std::int64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 100;
+			};
+			return toNs(kernelTime) + toNs(userTime);
+#else
+			timespec ts{};
+			if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+			{
+				return 0;
+			}
+			return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+		}
+	}
+
+	void CaptureTracker::SetPolicy(const CapturePolicy& policy) noexcept
+	{
+		m_policy = policy;
+	}
+
+	const CapturePolicy& CaptureTracker::GetPolicy() const noexcept
+	{
+		return m_policy;
+	}
+
+	CaptureState CaptureTracker::GetState() const noexcept
+	{
+		return m_state;
+	}
+
+	const CaptureStats& CaptureTracker::GetStats() const noexcept
+	{
+		return m_stats;
+	}
+
+	void CaptureTracker::ResetStats() noexcept
+	{
+		m_stats = CaptureStats{};
+	}
+
+	void CaptureTracker::OnUpdate(bool hadInput, std::chrono::steady_clock::time_point now) noexcept
+	{
+		if (hadInput)
+		{
+			m_lastInputTime = now;
+			if (m_state != CaptureState::kActive)
+			{
+				m_state = CaptureState::kActive;
+				++m_stats.idleToActiveCount;
+			}
+		}
+		else if (m_state == CaptureState::kActive && now - m_lastInputTime >= std::chrono::milliseconds{ m_policy.idleTimeoutMs })
+		{
+			m_state = CaptureState::kIdle;
+			++m_stats.activeToIdleCount;
+		}
+	}
+
+	void CaptureTracker::Reset(std::chrono::steady_clock::time_point now) noexcept
+	{
+		m_state = CaptureState::kActive;
+		m_lastInputTime = now;
+	}
+
+	std::chrono::milliseconds CaptureTracker::GetRescanInterval() const noexcept
+	{
+		return std::chrono::milliseconds{ m_state == CaptureState::kActive ? m_policy.activeRescanIntervalMs : m_policy.idleRescanIntervalMs };
+	}
+
+	std::chrono::microseconds CaptureTracker::GetSpinDuration() const noexcept
+	{
+		return std::chrono::microseconds{ m_state == CaptureState::kActive ? m_policy.activeSpinUs : 0 };
+	}
+
+	void CaptureTracker::AddWakeup() noexcept
+	{
+		if (m_state == CaptureState::kActive)
+		{
+			++m_stats.activeWakeups;
+		}
+		else
+		{
+			++m_stats.idleWakeups;
+		}
+	}
+
+	void CaptureTracker::AddCpuTime(CaptureState state, std::int64_t ns) noexcept
+	{
+		if (ns <= 0)
+		{
+			return;
+		}
+
+		if (state == CaptureState::kActive)
+		{
+			m_stats.activeCpuTimeNs += static_cast<std::uint64_t>(ns);
+		}
+		else
+		{
+			m_stats.idleCpuTimeNs += static_cast<std::uint64_t>(ns);
+		}
+	}
+
+	CaptureCpuScope::CaptureCpuScope(CaptureTracker& tracker, UpdateCounters& counters) noexcept
+		: m_tracker(tracker)
+		, m_counters(counters)
+		, m_state(tracker.GetState())
+		, m_enabled(tracker.GetPolicy().measureCpuTime)
+		, m_beginNs(m_enabled ? GetThreadCpuTimeNs() : 0)
+	{
+	}
+
+	CaptureCpuScope::~CaptureCpuScope()
+	{
+		if (m_enabled)
+		{
+			m_tracker.AddCpuTime(m_state, GetThreadCpuTimeNs() - m_beginNs);
+			m_counters.AddSyscalls(2);
+		}
+	}
+}
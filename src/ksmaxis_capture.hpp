@@ -0,0 +1,71 @@
+﻿#pragma once
+#include "ksmaxis/ksmaxis.hpp"
+#include "ksmaxis_update_stats.hpp"
+
+#include <chrono>
+#include <cstdint>
+
+namespace ksmaxis::detail
+{
+	// Active/idle bookkeeping for CapturePolicy, shared by the platform backends
+	class CaptureTracker
+	{
+	public:
+		void SetPolicy(const CapturePolicy& policy) noexcept;
+
+		[[nodiscard]]
+		const CapturePolicy& GetPolicy() const noexcept;
+
+		[[nodiscard]]
+		CaptureState GetState() const noexcept;
+
+		[[nodiscard]]
+		const CaptureStats& GetStats() const noexcept;
+
+		void ResetStats() noexcept;
+
+		// Called once per Update() with whether any axis moved
+		void OnUpdate(bool hadInput, std::chrono::steady_clock::time_point now) noexcept;
+
+		// Restarts the idle timer, e.g. on Init()
+		void Reset(std::chrono::steady_clock::time_point now) noexcept;
+
+		[[nodiscard]]
+		std::chrono::milliseconds GetRescanInterval() const noexcept;
+
+		// Busy-poll budget of WaitForInput() in the current state (zero while idle)
+		[[nodiscard]]
+		std::chrono::microseconds GetSpinDuration() const noexcept;
+
+		void AddWakeup() noexcept;
+
+		void AddCpuTime(CaptureState state, std::int64_t ns) noexcept;
+
+	private:
+		CapturePolicy m_policy;
+		CaptureState m_state = CaptureState::kActive;
+		std::chrono::steady_clock::time_point m_lastInputTime = std::chrono::steady_clock::now();
+		CaptureStats m_stats;
+	};
+
+	// Attributes the thread CPU time of a scope to the capture state it started in (no-op unless
+	// CapturePolicy::measureCpuTime is set). The two clock reads are counted as syscalls.
+	class CaptureCpuScope
+	{
+	public:
+		CaptureCpuScope(CaptureTracker& tracker, UpdateCounters& counters) noexcept;
+
+		~CaptureCpuScope();
+
+		CaptureCpuScope(const CaptureCpuScope&) = delete;
+
+		CaptureCpuScope& operator=(const CaptureCpuScope&) = delete;
+
+	private:
+		CaptureTracker& m_tracker;
+		UpdateCounters& m_counters;
+		CaptureState m_state;
+		bool m_enabled;
+		std::int64_t m_beginNs;
+	};
+}
@@ -0,0 +1,164 @@
+﻿#include "ksmaxis_curve.hpp"
+
+#include <cmath>
+
+namespace ksmaxis
+{
+	namespace
+	{
+		bool SetCurveError(std::string* pErrorString, const char* message)
+		{
+			if (pErrorString)
+			{
+				*pErrorString = message;
+			}
+			return false;
+		}
+
+		// Output of the curve before the deadzone and sensitivity, for an input in [0, inputMax]
+		double EvaluateCurveShape(const ResponseCurve& curve, double input)
+		{
+			switch (curve.type)
+			{
+			case ResponseCurveType::kPower:
+				return curve.inputMax * std::pow(input / curve.inputMax, curve.exponent);
+			case ResponseCurveType::kPiecewise:
+			{
+				const auto& points = curve.points;
+				std::size_t segment = 1;
+				while (segment + 1 < points.size() && input > points[segment][0])
+				{
+					++segment;
+				}
+				const auto& from = points[segment - 1];
+				const auto& to = points[segment];
+				const double span = to[0] - from[0];
+				return span > 0.0 ? from[1] + (to[1] - from[1]) * (input - from[0]) / span : to[1];
+			}
+			case ResponseCurveType::kCustom:
+				return curve.function(input);
+			default:
+				return input;
+			}
+		}
+	}
+
+	bool CompileResponseCurve(const ResponseCurve& curve, ResponseCurveTable& table, std::string* pErrorString)
+	{
+		if (!(curve.inputMax > 0.0) || !std::isfinite(curve.inputMax))
+		{
+			return SetCurveError(pErrorString, "Response curve inputMax must be positive");
+		}
+		if (!(curve.deadzone >= 0.0) || curve.deadzone >= curve.inputMax)
+		{
+			return SetCurveError(pErrorString, "Response curve deadzone must be in [0, inputMax)");
+		}
+		if (curve.type == ResponseCurveType::kPiecewise)
+		{
+			if (curve.points.size() < 2)
+			{
+				return SetCurveError(pErrorString, "Piecewise response curve needs at least two points");
+			}
+			for (std::size_t i = 1; i < curve.points.size(); ++i)
+			{
+				if (curve.points[i][0] < curve.points[i - 1][0])
+				{
+					return SetCurveError(pErrorString, "Piecewise response curve points must be in ascending input order");
+				}
+			}
+		}
+		if (curve.type == ResponseCurveType::kCustom && !curve.function)
+		{
+			return SetCurveError(pErrorString, "Custom response curve has no function");
+		}
+
+		ResponseCurveTable compiled;
+		compiled.inputMax = curve.inputMax;
+		for (std::size_t i = 0; i < ResponseCurveTable::kSize; ++i)
+		{
+			const double input = curve.inputMax * static_cast<double>(i) / static_cast<double>(ResponseCurveTable::kSize - 1);
+			if (input <= curve.deadzone)
+			{
+				compiled.values[i] = 0.0;
+				continue;
+			}
+
+			const double stretched = (input - curve.deadzone) / (curve.inputMax - curve.deadzone) * curve.inputMax;
+			const double output = EvaluateCurveShape(curve, stretched) * curve.sensitivity;
+			if (!std::isfinite(output))
+			{
+				return SetCurveError(pErrorString, "Response curve output is not finite");
+			}
+			compiled.values[i] = output;
+		}
+
+		table = compiled;
+		return true;
+	}
+}
+
+namespace ksmaxis::detail
+{
+	void ResponseCurveSet::Set(InputMode mode, const ResponseCurveTable& table) noexcept
+	{
+		if (!(table.inputMax > 0.0))
+		{
+			Clear(mode);
+			return;
+		}
+		m_tables[static_cast<std::size_t>(mode)] = table;
+		m_enabledModes |= InputModeBit(mode);
+	}
+
+	void ResponseCurveSet::Clear(InputMode mode) noexcept
+	{
+		m_enabledModes &= ~InputModeBit(mode);
+	}
+
+	void ResponseCurveSet::Apply(InputMode mode, AxisValues& deltas) const noexcept
+	{
+		if ((m_enabledModes & InputModeBit(mode)) == 0)
+		{
+			return;
+		}
+
+		const ResponseCurveTable& table = m_tables[static_cast<std::size_t>(mode)];
+		deltas[0] = table.Apply(deltas[0]);
+		deltas[1] = table.Apply(deltas[1]);
+	}
+
+	void LateDeltaShaper::OnUpdate(const std::array<AxisValues, kInputModeCount>& rawDeltas, const std::array<AxisValues, kInputModeCount>& shapedDeltas) noexcept
+	{
+		m_rawFrameDeltas = rawDeltas;
+		m_shapedFrameDeltas = shapedDeltas;
+	}
+
+	void LateDeltaShaper::Shape(const ResponseCurveSet& curves, std::array<AxisValues, kInputModeCount>& deltas) noexcept
+	{
+		for (std::size_t i = 0; i < kInputModeCount; ++i)
+		{
+			// Unchanged raw input leaves the shaped frame delta, and so the increment, exactly as it was
+			if (deltas[i][0] == 0.0 && deltas[i][1] == 0.0)
+			{
+				continue;
+			}
+
+			AxisValues& raw = m_rawFrameDeltas[i];
+			raw[0] += deltas[i][0];
+			raw[1] += deltas[i][1];
+
+			AxisValues shaped = raw;
+			curves.Apply(static_cast<InputMode>(i), shaped);
+
+			AxisValues& reported = m_shapedFrameDeltas[i];
+			deltas[i] = { shaped[0] - reported[0], shaped[1] - reported[1] };
+			reported = shaped;
+		}
+	}
+
+	void LateDeltaShaper::Reset() noexcept
+	{
+		m_rawFrameDeltas = {};
+		m_shapedFrameDeltas = {};
+	}
+}
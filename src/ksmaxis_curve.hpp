@@ -0,0 +1,42 @@
+﻿#pragma once
+#include "ksmaxis/ksmaxis.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace ksmaxis::detail
+{
+	// Per-mode response curves behind Context::SetResponseCurve()
+	class ResponseCurveSet
+	{
+	public:
+		void Set(InputMode mode, const ResponseCurveTable& table) noexcept;
+
+		void Clear(InputMode mode) noexcept;
+
+		// Shapes each axis of one Update()'s delta of the mode; a no-op for modes without a curve
+		void Apply(InputMode mode, AxisValues& deltas) const noexcept;
+
+	private:
+		std::array<ResponseCurveTable, kInputModeCount> m_tables{};
+		std::uint32_t m_enabledModes = 0; // InputModeBit() of the modes with a curve
+	};
+
+	// Shapes the input latched by LatchLateInput() together with the rest of its frame, so that the deltas of
+	// Update() and the late deltas sum to the curve applied to the frame's whole raw delta
+	class LateDeltaShaper
+	{
+	public:
+		// Starts a frame with the raw and shaped deltas of Update()
+		void OnUpdate(const std::array<AxisValues, kInputModeCount>& rawDeltas, const std::array<AxisValues, kInputModeCount>& shapedDeltas) noexcept;
+
+		// Replaces raw late deltas with the part of the shaped frame delta not reported yet
+		void Shape(const ResponseCurveSet& curves, std::array<AxisValues, kInputModeCount>& deltas) noexcept;
+
+		void Reset() noexcept;
+
+	private:
+		std::array<AxisValues, kInputModeCount> m_rawFrameDeltas{};
+		std::array<AxisValues, kInputModeCount> m_shapedFrameDeltas{};
+	};
+}
@@ -0,0 +1,222 @@
+﻿#include "ksmaxis_device_stats.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+namespace ksmaxis::detail
+{
+	DeviceCounterSlot* DeviceCounterTable::Acquire() noexcept
+	{
+		for (auto& slot : m_slots)
+		{
+			if (slot.deviceId.load(std::memory_order_relaxed) != 0)
+			{
+				continue;
+			}
+
+			slot.reportCount.store(0, std::memory_order_relaxed);
+			slot.droppedCount.store(0, std::memory_order_relaxed);
+			slot.eventCount.store(0, std::memory_order_relaxed);
+
+			// Ids aren't reused (except after 2^32 devices), so a reader can tell a replaced device apart
+			if (++m_lastDeviceId == 0)
+			{
+				m_lastDeviceId = 1;
+			}
+			slot.deviceId.store(m_lastDeviceId, std::memory_order_release);
+			return &slot;
+		}
+		return nullptr;
+	}
+
+	std::size_t DeviceCounterTable::Read(std::span<DeviceCounters> counters) const noexcept
+	{
+		std::size_t count = 0;
+		for (const auto& slot : m_slots)
+		{
+			if (count == counters.size())
+			{
+				break;
+			}
+
+			const std::uint32_t deviceId = slot.deviceId.load(std::memory_order_acquire);
+			if (deviceId == 0)
+			{
+				continue;
+			}
+
+			DeviceCounters& out = counters[count];
+			out.deviceId = deviceId;
+			out.reportCount = slot.reportCount.load(std::memory_order_relaxed);
+			out.droppedCount = slot.droppedCount.load(std::memory_order_relaxed);
+			out.eventCount = slot.eventCount.load(std::memory_order_relaxed);
+
+			// Skip a slot that was freed or handed to another device while it was being read
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.deviceId.load(std::memory_order_relaxed) == deviceId)
+			{
+				++count;
+			}
+		}
+		return count;
+	}
+
+	DeviceCounterHandle::DeviceCounterHandle(DeviceCounterSlot* pSlot) noexcept
+		: m_pSlot(pSlot)
+	{
+	}
+
+	DeviceCounterHandle::DeviceCounterHandle(DeviceCounterHandle&& other) noexcept
+		: m_pSlot(std::exchange(other.m_pSlot, nullptr))
+	{
+	}
+
+	DeviceCounterHandle& DeviceCounterHandle::operator=(DeviceCounterHandle&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Release();
+			m_pSlot = std::exchange(other.m_pSlot, nullptr);
+		}
+		return *this;
+	}
+
+	DeviceCounterHandle::~DeviceCounterHandle()
+	{
+		Release();
+	}
+
+	void DeviceCounterHandle::Release() noexcept
+	{
+		if (m_pSlot)
+		{
+			m_pSlot->deviceId.store(0, std::memory_order_release);
+			m_pSlot = nullptr;
+		}
+	}
+
+	bool DeviceTimingAccumulator::Attach(DeviceCounterTable& table) noexcept
+	{
+		DeviceCounterSlot* pSlot = table.Acquire();
+		if (!pSlot)
+		{
+			return false;
+		}
+		m_counters = DeviceCounterHandle{ pSlot };
+		return true;
+	}
+
+	void DeviceTimingAccumulator::Detach() noexcept
+	{
+		m_counters.Release();
+	}
+
+	std::uint32_t DeviceTimingAccumulator::GetDeviceId() const noexcept
+	{
+		const DeviceCounterSlot* pSlot = m_counters.Get();
+		return pSlot ? pSlot->deviceId.load(std::memory_order_relaxed) : 0;
+	}
+
+	void DeviceTimingAccumulator::AddReport(std::int64_t reportTimeNs, std::int64_t readTimeNs) noexcept
+	{
+		if (m_hasReport)
+		{
+			const double intervalUs = static_cast<double>(reportTimeNs - m_lastReportNs) / 1000.0;
+			m_intervalMinUs = m_intervalCount == 0 ? intervalUs : std::min(m_intervalMinUs, intervalUs);
+			m_intervalMaxUs = m_intervalCount == 0 ? intervalUs : std::max(m_intervalMaxUs, intervalUs);
+			m_intervalSumUs += intervalUs;
+			m_intervalSumSqUs += intervalUs * intervalUs;
+			++m_intervalCount;
+		}
+		else
+		{
+			m_firstReportNs = reportTimeNs;
+			m_hasReport = true;
+		}
+		m_lastReportNs = reportTimeNs;
+		if (DeviceCounterSlot* pSlot = m_counters.Get())
+		{
+			pSlot->reportCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (readTimeNs >= 0)
+		{
+			// Clamped since the two clocks may be sampled at slightly different points
+			const double latencyUs = std::max(0.0, static_cast<double>(readTimeNs - reportTimeNs) / 1000.0);
+			m_latencyMaxUs = std::max(m_latencyMaxUs, latencyUs);
+			m_latencySumUs += latencyUs;
+			++m_latencyCount;
+		}
+	}
+
+	void DeviceTimingAccumulator::AddDropped(std::uint64_t count) noexcept
+	{
+		if (DeviceCounterSlot* pSlot = m_counters.Get())
+		{
+			pSlot->droppedCount.fetch_add(count, std::memory_order_relaxed);
+		}
+	}
+
+	void DeviceTimingAccumulator::AddEvents(std::uint64_t count) noexcept
+	{
+		if (DeviceCounterSlot* pSlot = m_counters.Get())
+		{
+			pSlot->eventCount.fetch_add(count, std::memory_order_relaxed);
+		}
+	}
+
+	void DeviceTimingAccumulator::Reset() noexcept
+	{
+		DeviceCounterHandle counters = std::move(m_counters);
+		*this = DeviceTimingAccumulator{};
+		m_counters = std::move(counters);
+
+		if (DeviceCounterSlot* pSlot = m_counters.Get())
+		{
+			pSlot->reportCount.store(0, std::memory_order_relaxed);
+			pSlot->droppedCount.store(0, std::memory_order_relaxed);
+			pSlot->eventCount.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	DeviceStats DeviceTimingAccumulator::Summarize() const noexcept
+	{
+		DeviceStats stats;
+		if (const DeviceCounterSlot* pSlot = m_counters.Get())
+		{
+			stats.reportCount = pSlot->reportCount.load(std::memory_order_relaxed);
+			stats.eventCount = pSlot->eventCount.load(std::memory_order_relaxed);
+			stats.droppedCount = pSlot->droppedCount.load(std::memory_order_relaxed);
+		}
+
+		if (m_intervalCount > 0)
+		{
+			const double count = static_cast<double>(m_intervalCount);
+			stats.intervalMeanUs = m_intervalSumUs / count;
+			stats.intervalStdDevUs = std::sqrt(std::max(0.0, m_intervalSumSqUs / count - stats.intervalMeanUs * stats.intervalMeanUs));
+			stats.intervalMinUs = m_intervalMinUs;
+			stats.intervalMaxUs = m_intervalMaxUs;
+		}
+
+		if (m_lastReportNs > m_firstReportNs)
+		{
+			stats.reportRateHz = static_cast<double>(m_intervalCount) * 1e9 / static_cast<double>(m_lastReportNs - m_firstReportNs);
+		}
+
+		if (m_latencyCount > 0)
+		{
+			stats.hasLatency = true;
+			stats.latencyMeanUs = m_latencySumUs / static_cast<double>(m_latencyCount);
+			stats.latencyMaxUs = m_latencyMaxUs;
+		}
+
+		return stats;
+	}
+
+	std::int64_t GetMonotonicTimeNs() noexcept
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
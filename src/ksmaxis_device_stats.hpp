@@ -0,0 +1,117 @@
+﻿#pragma once
+#include "ksmaxis/ksmaxis.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+namespace ksmaxis::detail
+{
+	// Counts of one open device, readable from any thread through Context::GetDeviceCounters()
+	struct DeviceCounterSlot
+	{
+		std::atomic<std::uint32_t> deviceId{ 0 }; // 0: free
+		std::atomic<std::uint64_t> reportCount{ 0 };
+		std::atomic<std::uint64_t> droppedCount{ 0 };
+		std::atomic<std::uint64_t> eventCount{ 0 };
+	};
+
+	// Slots for the counters of all open devices. Kept apart from the device lists, whose elements move when a
+	// device is removed, so that a monitoring thread never reads a moving object.
+	class DeviceCounterTable
+	{
+	public:
+		static constexpr std::size_t kMaxDevices = 64;
+
+		// Returns nullptr if all slots are taken. Called only from the thread that calls Update().
+		[[nodiscard]]
+		DeviceCounterSlot* Acquire() noexcept;
+
+		// Copies the counts of up to counters.size() open devices and returns how many were written
+		std::size_t Read(std::span<DeviceCounters> counters) const noexcept;
+
+	private:
+		std::array<DeviceCounterSlot, kMaxDevices> m_slots;
+		std::uint32_t m_lastDeviceId = 0;
+	};
+
+	// Owns a DeviceCounterSlot and frees it on destruction
+	class DeviceCounterHandle
+	{
+	public:
+		DeviceCounterHandle() = default;
+
+		explicit DeviceCounterHandle(DeviceCounterSlot* pSlot) noexcept;
+
+		DeviceCounterHandle(DeviceCounterHandle&& other) noexcept;
+
+		DeviceCounterHandle& operator=(DeviceCounterHandle&& other) noexcept;
+
+		~DeviceCounterHandle();
+
+		DeviceCounterHandle(const DeviceCounterHandle&) = delete;
+
+		DeviceCounterHandle& operator=(const DeviceCounterHandle&) = delete;
+
+		[[nodiscard]]
+		DeviceCounterSlot* Get() const noexcept
+		{
+			return m_pSlot;
+		}
+
+		void Release() noexcept;
+
+	private:
+		DeviceCounterSlot* m_pSlot = nullptr;
+	};
+
+	// Per-device report timing, fed by the backends and summarized into DeviceStats by GetDevices().
+	// Move-only, since it owns the counter slot of the device (see Attach()).
+	class DeviceTimingAccumulator
+	{
+	public:
+		// Returns false if the table is full
+		bool Attach(DeviceCounterTable& table) noexcept;
+
+		// Frees the counter slot early, e.g. while the device waits for an in-flight read to finish
+		void Detach() noexcept;
+
+		// 0 if not attached
+		[[nodiscard]]
+		std::uint32_t GetDeviceId() const noexcept;
+
+		// Both times are monotonic nanoseconds. readTimeNs < 0 if the report timestamp isn't comparable to the read time.
+		void AddReport(std::int64_t reportTimeNs, std::int64_t readTimeNs) noexcept;
+
+		void AddDropped(std::uint64_t count = 1) noexcept;
+
+		void AddEvents(std::uint64_t count) noexcept;
+
+		// Keeps the counter slot and the device id
+		void Reset() noexcept;
+
+		[[nodiscard]]
+		DeviceStats Summarize() const noexcept;
+
+	private:
+		DeviceCounterHandle m_counters;
+		bool m_hasReport = false;
+		std::int64_t m_firstReportNs = 0;
+		std::int64_t m_lastReportNs = 0;
+
+		std::uint64_t m_intervalCount = 0;
+		double m_intervalSumUs = 0.0;
+		double m_intervalSumSqUs = 0.0;
+		double m_intervalMinUs = 0.0;
+		double m_intervalMaxUs = 0.0;
+
+		std::uint64_t m_latencyCount = 0;
+		double m_latencySumUs = 0.0;
+		double m_latencyMaxUs = 0.0;
+	};
+
+	// Monotonic clock in nanoseconds, on the same base as steady_clock
+	[[nodiscard]]
+	std::int64_t GetMonotonicTimeNs() noexcept;
+}
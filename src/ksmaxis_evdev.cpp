@@ -0,0 +1,122 @@
+﻿#ifdef __linux__
+
+#include "ksmaxis_evdev.hpp"
+#include "ksmaxis_axis.hpp"
+
+namespace ksmaxis::detail
+{
+	double NormalizeEvdevAxis(const EvdevKnobState& knobs, std::int32_t code, std::int32_t value)
+	{
+		if (code < 0 || code >= ABS_CNT || !knobs.ranges[code].available)
+		{
+			return 0.0;
+		}
+
+		std::int32_t min = knobs.ranges[code].min;
+		std::int32_t max = knobs.ranges[code].max;
+
+		if (max == min)
+		{
+			return 0.0;
+		}
+
+		// min~max -> 0.0~1.0
+		return static_cast<double>(value - min) / static_cast<double>(max - min);
+	}
+
+	void SeedEvdevKnobAxes(EvdevKnobState& knobs, const std::int32_t (&values)[ABS_CNT])
+	{
+		knobs.axisX = NormalizeEvdevAxis(knobs, ABS_X, values[ABS_X]);
+		knobs.axisY = NormalizeEvdevAxis(knobs, ABS_Y, values[ABS_Y]);
+		knobs.slider0 = knobs.ranges[ABS_THROTTLE].available ? NormalizeEvdevAxis(knobs, ABS_THROTTLE, values[ABS_THROTTLE]) : NormalizeEvdevAxis(knobs, ABS_MISC, values[ABS_MISC]);
+		knobs.slider1 = NormalizeEvdevAxis(knobs, ABS_RUDDER, values[ABS_RUDDER]);
+	}
+
+	void CommitJoystickPacket(EvdevKnobState& knobs, InputModeSet modes, std::int64_t packetTimeNs, TickResampler& resampler)
+	{
+		AxisValues stickDelta = { 0.0, 0.0 };
+		AxisValues sliderDelta = { 0.0, 0.0 };
+		for (std::size_t i = 0; i < std::size(kKnobAbsCodes); ++i)
+		{
+			if ((knobs.pendingMask & (1U << i)) == 0)
+			{
+				continue;
+			}
+
+			const int code = kKnobAbsCodes[i];
+			const double normalized = NormalizeEvdevAxis(knobs, code, knobs.pendingValues[i]);
+
+			// Correcting wrap-around per packet instead of per frame keeps fast spins from aliasing
+			// when the knob moves more than half a turn between two Update() calls
+			switch (code)
+			{
+			case ABS_X:
+				ApplyAxisValue(normalized, knobs.axisX, stickDelta[0], modes.Contains(InputMode::kAnalogStick));
+				break;
+			case ABS_Y:
+				ApplyAxisValue(normalized, knobs.axisY, stickDelta[1], modes.Contains(InputMode::kAnalogStick));
+				break;
+			case ABS_THROTTLE:
+			case ABS_MISC:
+				ApplyAxisValue(normalized, knobs.slider0, sliderDelta[0], modes.Contains(InputMode::kSlider));
+				break;
+			case ABS_RUDDER:
+				ApplyAxisValue(normalized, knobs.slider1, sliderDelta[1], modes.Contains(InputMode::kSlider));
+				break;
+			}
+		}
+		knobs.pendingMask = 0;
+
+		knobs.deltaAxisX += stickDelta[0];
+		knobs.deltaAxisY += stickDelta[1];
+		knobs.deltaSlider0 += sliderDelta[0];
+		knobs.deltaSlider1 += sliderDelta[1];
+		resampler.Add(InputMode::kAnalogStick, packetTimeNs, stickDelta[0], stickDelta[1]);
+		resampler.Add(InputMode::kSlider, packetTimeNs, sliderDelta[0], sliderDelta[1]);
+	}
+
+	void ProcessJoystickEvent(EvdevKnobState& knobs, DeviceTimingAccumulator& timing, const input_event& ev, std::int64_t readTimeNs, InputModeSet modes, TickResampler& resampler)
+	{
+		if (ev.type == EV_SYN)
+		{
+			if (ev.code == SYN_REPORT)
+			{
+				// The packet ending a SYN_DROPPED gap is incomplete, so it is thrown away
+				if (knobs.discardingPacket)
+				{
+					knobs.discardingPacket = false;
+					knobs.pendingMask = 0;
+					return;
+				}
+
+				const std::int64_t reportTimeNs = static_cast<std::int64_t>(ev.input_event_sec) * 1000000000 + static_cast<std::int64_t>(ev.input_event_usec) * 1000;
+				CommitJoystickPacket(knobs, modes, knobs.monotonicTimestamps ? reportTimeNs : readTimeNs, resampler);
+				timing.AddReport(reportTimeNs, knobs.monotonicTimestamps ? readTimeNs : -1);
+			}
+			else if (ev.code == SYN_DROPPED)
+			{
+				timing.AddDropped();
+				knobs.discardingPacket = true;
+				knobs.pendingMask = 0;
+			}
+			return;
+		}
+
+		if (ev.type != EV_ABS || knobs.discardingPacket)
+		{
+			return;
+		}
+
+		for (std::size_t i = 0; i < std::size(kKnobAbsCodes); ++i)
+		{
+			if (kKnobAbsCodes[i] == ev.code)
+			{
+				knobs.pendingValues[i] = ev.value;
+				knobs.pendingMask = static_cast<std::uint8_t>(knobs.pendingMask | (1U << i));
+				break;
+			}
+		}
+	}
+}
+
+#endif
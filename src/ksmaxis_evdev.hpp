@@ -0,0 +1,63 @@
+﻿#pragma once
+#ifdef __linux__
+
+#include "ksmaxis/ksmaxis.hpp"
+#include "ksmaxis_device_stats.hpp"
+#include "ksmaxis_modes.hpp"
+#include "ksmaxis_resample.hpp"
+
+#include <linux/input.h>
+
+#include <cstdint>
+#include <iterator>
+
+namespace ksmaxis::detail
+{
+	// The axes ProcessJoystickEvent() reads; nodes without any of them are never opened
+	inline constexpr int kKnobAbsCodes[] = { ABS_X, ABS_Y, ABS_THROTTLE, ABS_MISC, ABS_RUDDER };
+
+	struct AxisRange
+	{
+		std::int32_t min = 0;
+		std::int32_t max = 255;
+		bool available = false;
+	};
+
+	// Knob axes of one evdev device: ranges and positions from EVIOCGABS, and the packet being assembled
+	struct EvdevKnobState
+	{
+		AxisRange ranges[ABS_CNT]{};
+		bool monotonicTimestamps = false; // Event times are CLOCK_MONOTONIC (EVIOCSCLOCKID succeeded)
+
+		double axisX = 0.0;
+		double axisY = 0.0;
+		double slider0 = 0.0;
+		double slider1 = 0.0;
+		// Wrap-corrected deltas accumulated per packet since the last Update()
+		double deltaAxisX = 0.0;
+		double deltaAxisY = 0.0;
+		double deltaSlider0 = 0.0;
+		double deltaSlider1 = 0.0;
+
+		// Raw values of the current packet (indexed like kKnobAbsCodes), applied together on SYN_REPORT
+		std::int32_t pendingValues[std::size(kKnobAbsCodes)] = {};
+		std::uint8_t pendingMask = 0;
+		bool discardingPacket = false; // From SYN_DROPPED until the next SYN_REPORT
+	};
+
+	// min~max -> 0.0~1.0; 0.0 for axes without a range
+	[[nodiscard]]
+	double NormalizeEvdevAxis(const EvdevKnobState& knobs, std::int32_t code, std::int32_t value);
+
+	// Starts from the current positions (EVIOCGABS values, indexed by ABS code) so that the first event of a
+	// hotplugged device isn't a jump from 0. The ranges must be set first.
+	void SeedEvdevKnobAxes(EvdevKnobState& knobs, const std::int32_t (&values)[ABS_CNT]);
+
+	// Applies the staged values of a packet, so that a frame never sees half of a hardware report
+	void CommitJoystickPacket(EvdevKnobState& knobs, InputModeSet modes, std::int64_t packetTimeNs, TickResampler& resampler);
+
+	// readTimeNs is only used for SYN_REPORT
+	void ProcessJoystickEvent(EvdevKnobState& knobs, DeviceTimingAccumulator& timing, const input_event& ev, std::int64_t readTimeNs, InputModeSet modes, TickResampler& resampler);
+}
+
+#endif
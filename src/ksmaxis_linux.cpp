@@ -1,459 +1,3729 @@
 ﻿#ifdef __linux__
 
 #include "ksmaxis/ksmaxis.hpp"
+#include "ksmaxis_trace.hpp"
+#include "ksmaxis_capture.hpp"
+#include "ksmaxis_device_stats.hpp"
+#include "ksmaxis_axis.hpp"
+#include "ksmaxis_evdev.hpp"
+#include "ksmaxis_modes.hpp"
+#include "ksmaxis_update_stats.hpp"
+#include "ksmaxis_budget.hpp"
+#include "ksmaxis_waiters.hpp"
+#include "ksmaxis_resample.hpp"
+#include "ksmaxis_curve.hpp"
 
 #include <linux/input.h>
+#include <linux/hidraw.h>
 #include <fcntl.h>
 #include <unistd.h>
-#include <dirent.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
 #include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/syscall.h>
+#include <dlfcn.h>
 #include <X11/Xlib.h>
 #include <X11/extensions/XInput2.h>
 
+#ifdef KSMAXIS_LINUX_IO_URING
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#endif
+
+#ifdef KSMAXIS_LINUX_WAYLAND
+#include <wayland-client.h>
+#include "relative-pointer-unstable-v1-client-protocol.h"
+#include "pointer-constraints-unstable-v1-client-protocol.h"
+#endif
+
+// X11/X.h defines None as a macro, which collides with DeviceFlags::None
+#undef None
+
 #include <vector>
 #include <string>
+#include <array>
+#include <bitset>
+#include <algorithm>
+#include <cstddef>
 #include <cstring>
+#include <cstdio>
+#include <cstdlib>
 #include <climits>
 #include <chrono>
 #include <cerrno>
+#ifdef KSMAXIS_LINUX_IO_URING
+#include <atomic>
+#endif
 
 namespace ksmaxis
 {
+	using detail::AxisRange;
+	using detail::AxisTotals;
+	using detail::CalculateDelta;
+	using detail::ChangeTracker;
+	using detail::DeviceCounterTable;
+	using detail::DeviceTimingAccumulator;
+	using detail::EvdevKnobState;
+	using detail::GetMonotonicTimeNs;
+	using detail::InputModeSet;
+	using detail::kKnobAbsCodes;
+	using detail::LateDeltaShaper;
+	using detail::ProcessJoystickEvent;
+	using detail::ResponseCurveSet;
+	using detail::SeedEvdevKnobAxes;
+	using detail::TickResampler;
+	using detail::UpdateBudgetScope;
+	using detail::UpdateCounters;
+
 	namespace
 	{
 		constexpr std::size_t kBitsPerLong = CHAR_BIT * sizeof(unsigned long);
-		constexpr double kWrapThreshold = 0.5;
 
-		struct AxisRange
+		// Device storage is fixed so that Update() and hotplug rescans never allocate
+		constexpr std::size_t kMaxJoystickDevices = 32;
+		constexpr std::size_t kDevicePathSize = 64;
+		constexpr std::size_t kDeviceNameSize = 128;
+		constexpr char kInputDirPath[] = "/dev/input/";
+		constexpr std::size_t kDirentBufferSize = 4096;
+
+		// Input nodes are classified from sysfs and the udev database before anything is opened
+		constexpr char kInputClassDirPath[] = "/sys/class/input/";
+		constexpr char kUdevDataDirPath[] = "/run/udev/data/";
+		constexpr std::size_t kSysfsFileBufferSize = 512;
+		constexpr std::size_t kUdevDataBufferSize = 8192;
+		constexpr std::size_t kMaxRejectedEventNodes = 256; // eventN numbers whose rejection is remembered
+		constexpr std::size_t kPhysicalDeviceKeySize = 128; // EVIOCGPHYS and EVIOCGUNIQ, or the sysfs parent path
+
+		constexpr std::size_t kMaxHidrawDevices = 8;
+		constexpr std::size_t kMaxHidrawFields = 8;
+		constexpr std::size_t kHidrawReportBufferSize = 1024;
+		constexpr std::size_t kHidMaxUsages = 32;
+		constexpr std::size_t kHidGlobalStackDepth = 4;
+		constexpr char kHidrawClassDirPath[] = "/sys/class/hidraw";
+		constexpr char kDevDirPath[] = "/dev/";
+
+		// XInput2 slave pointers selected through SetX11MouseDevices()
+		constexpr std::size_t kMaxX11MouseDevices = 8;
+
+		// Evdev and hidraw fds, plus the io_uring ring and the X11 or Wayland connection
+		constexpr std::size_t kMaxPollFds = kMaxJoystickDevices + kMaxHidrawDevices + 2;
+
+		static_assert(kMaxJoystickDevices + kMaxHidrawDevices <= DeviceCounterTable::kMaxDevices, "Every open device needs a counter slot");
+
+		// Alignment of ContextImpl, so that SetRealtimeCapture() locks whole pages of its own
+		constexpr std::size_t kContextPageAlignment = 4096;
+
+#ifdef KSMAXIS_LINUX_IO_URING
+		constexpr unsigned kIoUringMaxSlots = static_cast<unsigned>(kMaxJoystickDevices);
+		constexpr unsigned kIoUringEventsPerRead = 64;
+		constexpr unsigned kIoUringMaxDrainPasses = 4;
+		constexpr std::uint64_t kIoUringCancelUserData = ~0ULL;
+		constexpr std::uint64_t kIoUringPollUserDataFlag = 1ULL << 32; // Set on the poll linked before each read
+#endif
+
+#ifdef KSMAXIS_LINUX_WAYLAND
+		// wl_pointer.release needs version 3; later versions only add events that are not listened to
+		constexpr std::uint32_t kWaylandSeatVersion = 5;
+
+		// relative_motion timestamps older than this after rebasing mean the compositor clock stepped back
+		constexpr std::int64_t kWaylandMaxEventAgeNs = 1000000000;
+#endif
+
+		template <typename T, std::size_t Capacity>
+		class StaticVector
+		{
+		public:
+			T* begin() { return m_items.data(); }
+			T* end() { return m_items.data() + m_size; }
+			const T* begin() const { return m_items.data(); }
+			const T* end() const { return m_items.data() + m_size; }
+			T& back() { return m_items[m_size - 1]; }
+			std::size_t size() const { return m_size; }
+			bool full() const { return m_size == Capacity; }
+
+			bool push_back(T&& item)
+			{
+				if (full())
+				{
+					return false;
+				}
+				m_items[m_size++] = std::move(item);
+				return true;
+			}
+
+			T* erase(T* it)
+			{
+				std::move(it + 1, end(), it);
+				m_items[--m_size] = T{};
+				return it;
+			}
+
+			void clear()
+			{
+				for (T& item : *this)
+				{
+					item = T{};
+				}
+				m_size = 0;
+			}
+
+		private:
+			std::array<T, Capacity> m_items{};
+			std::size_t m_size = 0;
+		};
+
+		// Record layout returned by getdents64()
+		struct LinuxDirent64
 		{
-			std::int32_t min = 0;
-			std::int32_t max = 255;
-			bool available = false;
+			std::uint64_t ino;
+			std::int64_t off;
+			unsigned short reclen;
+			unsigned char type;
+			char name[1];
 		};
 
 		struct JoystickDevice
 		{
-			std::string path;
+			char path[kDevicePathSize] = {};
+			char name[kDeviceNameSize] = {};
 			int fd = -1;
-			double axisX = 0.0;
-			double axisY = 0.0;
-			double slider0 = 0.0;
-			double slider1 = 0.0;
-			double prevAxisX = 0.0;
-			double prevAxisY = 0.0;
-			double prevSlider0 = 0.0;
-			double prevSlider1 = 0.0;
-			AxisRange ranges[ABS_CNT]{};
+			EvdevKnobState knobs;
+			std::uint16_t vendorId = 0;
+			std::uint16_t productId = 0;
+			DeviceTimingAccumulator timing;
 			bool opened = false;
+			bool grabbed = false; // EVIOCGRAB held, see SetExclusiveGrab()
+#ifdef KSMAXIS_LINUX_IO_URING
+			int uringSlot = -1;
+			bool uringReadPending = false;
+#endif
+
+			// Identifies the physical device among sibling interfaces (empty: not grouped), see ReadPhysicalDeviceKey()
+			char physicalKey[kPhysicalDeviceKeySize] = {};
+			std::size_t knobAxisCount = 0;
+		};
+
+		// An evdev interface left closed because a sibling interface of the same physical device carries more knob axes
+		struct SuppressedEventNode
+		{
+			char path[kDevicePathSize] = {};
+			char keptPath[kDevicePathSize] = {};
+		};
+
+		enum HidrawAxis : std::uint8_t
+		{
+			kHidrawAxisX,
+			kHidrawAxisY,
+			kHidrawSlider0,
+			kHidrawSlider1,
+			kHidrawAxisCount,
+		};
+
+		// Extractor for one input field, compiled from the report descriptor when the device is opened
+		struct HidrawField
+		{
+			std::uint8_t reportId = 0;
+			std::uint32_t byteOffset = 0;
+			std::uint32_t byteCount = 0;
+			std::uint32_t shift = 0;
+			std::uint32_t mask = 0;
+			std::uint32_t signBit = 0; // 0 if the field is unsigned
+			std::int32_t logicalMin = 0;
+			std::int32_t logicalMax = 0;
+			HidrawAxis axis = kHidrawAxisX;
+			double value = 0.0;
+			bool hasValue = false;
+		};
+
+		struct HidrawDevice
+		{
+			char path[kDevicePathSize] = {};
+			char name[kDeviceNameSize] = {};
+			int fd = -1;
+			std::uint16_t vendorId = 0;
+			std::uint16_t productId = 0;
+			bool usesReportIds = false;
+			HidrawField fields[kMaxHidrawFields]{};
+			std::size_t fieldCount = 0;
+			double deltas[kHidrawAxisCount] = {};
+			DeviceTimingAccumulator timing;
+		};
+
+		// libX11 and libXi are loaded on the first Init(DeviceFlags::Mouse) instead of being linked, so that
+		// joystick-only users don't load Xlib at startup or need it installed at all
+		struct X11Api
+		{
+			decltype(&::XOpenDisplay) XOpenDisplay = nullptr;
+			decltype(&::XCloseDisplay) XCloseDisplay = nullptr;
+			decltype(&::XQueryExtension) XQueryExtension = nullptr;
+			decltype(&::XFlush) XFlush = nullptr;
+			decltype(&::XPending) XPending = nullptr;
+			decltype(&::XEventsQueued) XEventsQueued = nullptr;
+			decltype(&::XNextEvent) XNextEvent = nullptr;
+			decltype(&::XGetEventData) XGetEventData = nullptr;
+			decltype(&::XFreeEventData) XFreeEventData = nullptr;
+			decltype(&::XIQueryVersion) XIQueryVersion = nullptr;
+			decltype(&::XISelectEvents) XISelectEvents = nullptr;
+			decltype(&::XIQueryDevice) XIQueryDevice = nullptr;
+			decltype(&::XIFreeDeviceInfo) XIFreeDeviceInfo = nullptr;
+			bool loaded = false;
+			std::string error; // dlerror() if loading failed
 		};
 
 		struct X11MouseContext
 		{
+			const X11Api* api = nullptr; // Set while the display is open
 			Display* display = nullptr;
 			int xiOpcode = -1;
 			double deltaX = 0.0;
 			double deltaY = 0.0;
 			bool initialized = false;
+
+			// Slave pointers RawMotion is currently selected on (none while following the master pointers)
+			int selectedDeviceIds[kMaxX11MouseDevices] = {};
+			std::size_t selectedDeviceCount = 0;
+			bool reselectPending = false; // Set by XI_HierarchyChanged
+		};
+
+#ifdef KSMAXIS_LINUX_WAYLAND
+		struct WaylandMouseContext
+		{
+			// Owned by the application (see SetWaylandSurface())
+			wl_display* display = nullptr;
+			wl_surface* surface = nullptr;
+
+			// Private queue, so that dispatching it never runs the application's listeners
+			wl_event_queue* queue = nullptr;
+			wl_display* displayWrapper = nullptr;
+			wl_registry* registry = nullptr;
+
+			wl_seat* seat = nullptr;
+			std::uint32_t seatName = 0;
+			wl_pointer* pointer = nullptr;
+			zwp_relative_pointer_manager_v1* relativePointerManager = nullptr;
+			zwp_relative_pointer_v1* relativePointer = nullptr;
+			zwp_pointer_constraints_v1* pointerConstraints = nullptr;
+			zwp_locked_pointer_v1* lockedPointer = nullptr;
+			bool lockPointer = true;
+			TickResampler* resampler = nullptr;
+
+			double deltaX = 0.0;
+			double deltaY = 0.0;
+			// The base of relative_motion timestamps is unspecified, so they are rebased onto GetMonotonicTimeNs() with the
+			// smallest (dispatch time - timestamp) seen, i.e. relative to the fastest delivery
+			std::int64_t dispatchTimeNs = 0; // GetMonotonicTimeNs() sampled before dispatching the queue
+			std::int64_t timeOffsetNs = 0;
+			bool hasTimeOffset = false;
+			std::int64_t lastMotionTimeNs = 0; // Rebased timestamp of the last relative motion
+			bool initialized = false;
+		};
+#endif
+
+#ifdef KSMAXIS_LINUX_IO_URING
+		struct IoUringContext
+		{
+			int ringFd = -1;
+			void* sqRingPtr = nullptr;
+			std::size_t sqRingSize = 0;
+			void* cqRingPtr = nullptr;
+			std::size_t cqRingSize = 0;
+			io_uring_sqe* sqes = nullptr;
+			std::size_t sqesSize = 0;
+			unsigned sqEntries = 0;
+			unsigned* sqHead = nullptr;
+			unsigned* sqTail = nullptr;
+			unsigned* sqRingMask = nullptr;
+			unsigned* sqArray = nullptr;
+			unsigned* cqHead = nullptr;
+			unsigned* cqTail = nullptr;
+			unsigned* cqRingMask = nullptr;
+			io_uring_cqe* cqes = nullptr;
+			unsigned pendingSubmissions = 0;
+			input_event buffers[kIoUringMaxSlots * kIoUringEventsPerRead] = {};
+			bool buffersRegistered = false;
+			bool slotUsed[kIoUringMaxSlots] = {};
+			bool initialized = false;
+			bool failed = false; // io_uring_enter() failed for good; torn down by DrainIoUring() or CollectPollFds()
+		};
+#endif
+	}
+
+	namespace detail
+	{
+		// State owned by a Context (no process-global mutable state). Page-aligned, so that the object covers whole
+		// pages of its own and the mlock()/munlock() of SetRealtimeCapture() never touches memory of other objects.
+		struct alignas(kContextPageAlignment) ContextImpl
+		{
+			// Declared before the device lists, whose devices free their counter slots when destroyed
+			DeviceCounterTable deviceCounters;
+			StaticVector<JoystickDevice, kMaxJoystickDevices> joystickDevices;
+			int inputDirFd = -1;
+			int inputClassDirFd = -1; // /sys/class/input
+			int udevDataDirFd = -1; // /run/udev/data
+
+			// Event nodes known to have no knob axis, valid while the mtime of /dev/input is unchanged
+			// (node numbers are only reused after a node is removed and created again)
+			std::bitset<kMaxRejectedEventNodes> rejectedEventNodes;
+			timespec inputDirMtime{};
+			StaticVector<SuppressedEventNode, kMaxJoystickDevices> suppressedEventNodes; // Valid for the same time
+			std::vector<HidrawAxisMapping> hidrawAxisMappings;
+			StaticVector<HidrawDevice, kMaxHidrawDevices> hidrawDevices;
+			int hidrawClassDirFd = -1;
+			X11MouseContext x11Mouse;
+			std::vector<std::string> x11MouseDevices; // See SetX11MouseDevices()
+#ifdef KSMAXIS_LINUX_WAYLAND
+			WaylandMouseContext waylandMouse;
+#endif
+
+			bool exclusiveGrab = false; // See SetExclusiveGrab()
+
+			// See SetRealtimeCapture()
+			RealtimeCaptureConfig realtimeCapture;
+			bool realtimeCapturePending = false;
+			bool memoryLocked = false;
+
+			// See SetWaylandSurface()
+			void* waylandDisplay = nullptr;
+			void* waylandSurface = nullptr;
+			bool waylandLockPointer = true;
+#ifdef KSMAXIS_LINUX_IO_URING
+			IoUringContext ioUring;
+#endif
+			DeviceFlags initializedDevices = DeviceFlags::None;
+			DeviceFlags requestedDevices = DeviceFlags::None; // Passed to Init(), including devices deferred by activeModes
+			InputModeSet activeModes = InputModeSet::All();
+			bool firstUpdate = true;
+			AxisValues deltaAnalogStick = { 0.0, 0.0 };
+			AxisValues deltaSlider = { 0.0, 0.0 };
+			AxisValues deltaMouse = { 0.0, 0.0 };
+			AxisTotals axisTotals;
+			ChangeTracker changeTracker;
+			ResponseCurveSet responseCurves;
+			std::chrono::steady_clock::time_point lastScanTime;
+			CaptureTracker capture;
+			UpdateCounters counters;
+			UpdateBudget updateBudget;
+			bool lastUpdateTruncated = false;
+			std::size_t drainStartSource = 0; // See DrainInputSources()
+			detail::InputWaiterList inputWaiters;
+			TickResampler tickResampler;
+			std::array<AxisValues, kInputModeCount> lateDeltas{}; // See LatchLateInput()
+			LateDeltaShaper lateShaper;
+
+			// Created by GetPollFd() and kept across Terminate()/Init() so that callers can register it once
+			int epollFd = -1;
+			int epollRegisteredFds[kMaxPollFds] = {};
+			std::size_t epollRegisteredFdCount = 0;
+			// The fds of CollectPollFds() changed: a device was opened (possibly reusing the number of a closed fd) or
+			// moved off io_uring, or the devices were terminated. SyncEpollFd() only does work when this is set.
+			bool epollFdsChanged = false;
 		};
+	}
+
+	using detail::ContextImpl;
 
-		std::vector<JoystickDevice> s_joystickDevices;
-		X11MouseContext s_x11Mouse;
-		DeviceFlags s_initializedDevices = DeviceFlags::None;
-		bool s_firstUpdate = true;
-		AxisValues s_deltaAnalogStick = { 0.0, 0.0 };
-		AxisValues s_deltaSlider = { 0.0, 0.0 };
-		AxisValues s_deltaMouse = { 0.0, 0.0 };
-		std::chrono::steady_clock::time_point s_lastScanTime;
+	namespace
+	{
+		// Like every other syscall of the library, counted into UpdateStats::syscallCount
+		void CloseFd(UpdateCounters& counters, int fd)
+		{
+			close(fd);
+			counters.AddSyscalls(1);
+		}
 
-		double Normalize(const JoystickDevice& dev, std::int32_t code, std::int32_t value)
+		// Returns false if the device is gone (-ENODEV)
+		bool DrainJoystickDevice(JoystickDevice& dev, InputModeSet modes, UpdateCounters& counters, UpdateBudgetScope& budget, TickResampler& resampler)
 		{
-			if (code < 0 || code >= ABS_CNT || !dev.ranges[code].available)
+			KSMAXIS_TRACE_SCOPE(trace, "DrainJoystickDevice");
+			KSMAXIS_TRACE_LABEL(trace, dev.path);
+
+			std::size_t eventCount = 0;
+			std::size_t readCount = 0;
+			int readError = 0;
+			struct input_event ev{};
+			while (!budget.IsExhausted())
 			{
-				return 0.0;
+				const ssize_t size = read(dev.fd, &ev, sizeof(ev));
+				++readCount;
+				if (size != sizeof(ev))
+				{
+					readError = size < 0 ? errno : 0;
+					break;
+				}
+				// Read time is only needed once per packet
+				const std::int64_t readTimeNs = ev.type == EV_SYN && ev.code == SYN_REPORT ? GetMonotonicTimeNs() : 0;
+				ProcessJoystickEvent(dev.knobs, dev.timing, ev, readTimeNs, modes, resampler);
+				budget.AddEvents(1);
+				++eventCount;
 			}
 
-			std::int32_t min = dev.ranges[code].min;
-			std::int32_t max = dev.ranges[code].max;
+			dev.timing.AddEvents(eventCount);
+			counters.AddEvents(eventCount);
+			counters.AddSyscalls(readCount);
+
+			KSMAXIS_TRACE_ARG(trace, "events", eventCount);
+			return readError != ENODEV;
+		}
+
+#ifdef KSMAXIS_LINUX_IO_URING
+		// io_uring reader: one pre-posted read per evdev fd into a slot of a registered buffer arena.
+		// Completions are harvested from the shared CQ ring without syscalls, and all re-reads are
+		// submitted together, so an idle frame costs no syscalls and an active one costs one per pass.
+		// Devices that don't get a slot, or all devices if the ring can't be set up, use read().
+		// The fds stay O_NONBLOCK and each read is linked behind a poll: a blocking read would park an
+		// io-wq worker thread per device until input arrives, while the poll waits in the kernel for free.
+
+		int IoUringSetup(unsigned entries, io_uring_params* params)
+		{
+			return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+		}
+
+		int IoUringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+		{
+			return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+		}
+
+		int IoUringRegister(int ringFd, unsigned opcode, const void* arg, unsigned numArgs)
+		{
+			return static_cast<int>(syscall(__NR_io_uring_register, ringFd, opcode, arg, numArgs));
+		}
+
+		input_event* GetIoUringSlotBuffer(ContextImpl& context, int slot)
+		{
+			return context.ioUring.buffers + static_cast<std::size_t>(slot) * kIoUringEventsPerRead;
+		}
+
+		bool HasIoUringSqRoom(const ContextImpl& context, unsigned count)
+		{
+			const unsigned head = std::atomic_ref<unsigned>{ *context.ioUring.sqHead }.load(std::memory_order_acquire);
+			return *context.ioUring.sqTail - head + count <= context.ioUring.sqEntries;
+		}
 
-			if (max == min)
+		bool QueueIoUringSqe(ContextImpl& context, const io_uring_sqe& sqe)
+		{
+			unsigned tail = *context.ioUring.sqTail;
+			unsigned head = std::atomic_ref<unsigned>{ *context.ioUring.sqHead }.load(std::memory_order_acquire);
+			if (tail - head >= context.ioUring.sqEntries)
 			{
-				return 0.0;
+				return false;
 			}
 
-			// min~max -> 0.0~1.0
-			return static_cast<double>(value - min) / static_cast<double>(max - min);
+			unsigned index = tail & *context.ioUring.sqRingMask;
+			context.ioUring.sqes[index] = sqe;
+			context.ioUring.sqArray[index] = index;
+			std::atomic_ref<unsigned>{ *context.ioUring.sqTail }.store(tail + 1, std::memory_order_release);
+			++context.ioUring.pendingSubmissions;
+			return true;
 		}
 
-		double CalculateDelta(double current, double prev)
+		void ReleaseIoUringSlot(ContextImpl& context, int slot)
 		{
-			double delta = current - prev;
+			if (slot >= 0 && slot < static_cast<int>(kIoUringMaxSlots))
+			{
+				context.ioUring.slotUsed[slot] = false;
+			}
+		}
 
-			// Wrap-around correction
-			if (delta > kWrapThreshold)
+		// Returns false if the SQ ring is full (SQEs left queued by a busy io_uring_enter()); the device then
+		// gives up its slot and is read with read() from now on
+		bool QueueIoUringRead(ContextImpl& context, JoystickDevice& dev)
+		{
+			// The poll and the read must be queued together, or the link would attach the read to the next SQE
+			if (!HasIoUringSqRoom(context, 2))
 			{
-				delta -= 1.0;
+				ReleaseIoUringSlot(context, dev.uringSlot);
+				dev.uringSlot = -1;
+				context.epollFdsChanged = true;
+				return false;
 			}
-			else if (delta < -kWrapThreshold)
+
+			// If the poll fails, the linked read completes with -ECANCELED
+			io_uring_sqe pollSqe{};
+			pollSqe.opcode = IORING_OP_POLL_ADD;
+			pollSqe.flags = IOSQE_IO_LINK;
+			pollSqe.fd = dev.fd;
+			pollSqe.poll32_events = POLLIN;
+			pollSqe.user_data = static_cast<std::uint64_t>(dev.uringSlot) | kIoUringPollUserDataFlag;
+			QueueIoUringSqe(context, pollSqe);
+
+			io_uring_sqe sqe{};
+			sqe.opcode = context.ioUring.buffersRegistered ? IORING_OP_READ_FIXED : IORING_OP_READ;
+			sqe.fd = dev.fd;
+			sqe.addr = reinterpret_cast<std::uint64_t>(GetIoUringSlotBuffer(context, dev.uringSlot));
+			sqe.len = kIoUringEventsPerRead * sizeof(input_event);
+			sqe.off = static_cast<std::uint64_t>(-1); // Current file position (character device)
+			sqe.buf_index = 0;
+			sqe.user_data = static_cast<std::uint64_t>(dev.uringSlot);
+			QueueIoUringSqe(context, sqe);
+			dev.uringReadPending = true;
+			return true;
+		}
+
+		// Cancels the poll and the read of a device; the read then completes with -ECANCELED unless it already finished.
+		// Returns false if the SQ ring is full, in which case nothing is queued.
+		[[nodiscard]]
+		bool QueueIoUringCancel(ContextImpl& context, const JoystickDevice& dev)
+		{
+			if (!HasIoUringSqRoom(context, 2))
 			{
-				delta += 1.0;
+				return false;
 			}
 
-			return delta;
+			for (const std::uint64_t target : { static_cast<std::uint64_t>(dev.uringSlot) | kIoUringPollUserDataFlag, static_cast<std::uint64_t>(dev.uringSlot) })
+			{
+				io_uring_sqe sqe{};
+				sqe.opcode = IORING_OP_ASYNC_CANCEL;
+				sqe.fd = -1;
+				sqe.addr = target;
+				sqe.user_data = kIoUringCancelUserData;
+				QueueIoUringSqe(context, sqe);
+			}
+			return true;
 		}
 
-		bool IsJoystickDeviceAlreadyOpened(const std::string& path)
+		void SubmitIoUring(ContextImpl& context)
 		{
-			for (const auto& dev : s_joystickDevices)
+			if (!context.ioUring.initialized || context.ioUring.failed || context.ioUring.pendingSubmissions == 0)
 			{
-				if (dev.path == path)
-				{
-					return true;
-				}
+				return;
+			}
+
+			const int ret = IoUringEnter(context.ioUring.ringFd, context.ioUring.pendingSubmissions, 0, 0);
+			context.counters.AddSyscalls(1);
+			if (ret >= 0)
+			{
+				context.ioUring.pendingSubmissions -= static_cast<unsigned>(ret);
+				return;
+			}
+
+			// EBUSY (CQ ring overflowing) and EAGAIN (out of memory) leave the SQEs queued; DrainIoUring() retries
+			// them after harvesting. Anything else means the ring is unusable.
+			if (errno != EBUSY && errno != EAGAIN && errno != EINTR)
+			{
+				context.ioUring.failed = true;
 			}
-			return false;
 		}
 
-		void RemoveDisconnectedJoystickDevices()
+		bool AttachIoUring(ContextImpl& context, JoystickDevice& dev)
 		{
-			for (auto it = s_joystickDevices.begin(); it != s_joystickDevices.end();)
+			if (!context.ioUring.initialized)
 			{
-				if (!it->opened || it->fd < 0)
+				return false;
+			}
+
+			for (unsigned slot = 0; slot < kIoUringMaxSlots; ++slot)
+			{
+				if (context.ioUring.slotUsed[slot])
 				{
-					++it;
 					continue;
 				}
 
-				struct input_id id;
-				if (ioctl(it->fd, EVIOCGID, &id) < 0)
-				{
-					close(it->fd);
-					it = s_joystickDevices.erase(it);
-				}
-				else
+				context.ioUring.slotUsed[slot] = true;
+				dev.uringSlot = static_cast<int>(slot);
+				return QueueIoUringRead(context, dev);
+			}
+
+			// Out of slots, keep using read()
+			return false;
+		}
+
+		JoystickDevice* FindIoUringJoystickDevice(ContextImpl& context, int slot)
+		{
+			for (auto& dev : context.joystickDevices)
+			{
+				if (dev.uringSlot == slot)
 				{
-					++it;
+					return &dev;
 				}
 			}
+			return nullptr;
 		}
 
-		void ScanJoystickDevices()
+		void HandleIoUringCompletion(ContextImpl& context, const io_uring_cqe& cqe, UpdateBudgetScope& budget)
 		{
-			DIR* dir = opendir("/dev/input");
-			if (!dir)
+			// A failed poll is reported again by its linked read
+			if (cqe.user_data == kIoUringCancelUserData || (cqe.user_data & kIoUringPollUserDataFlag) != 0)
 			{
 				return;
 			}
 
-			struct dirent* entry;
-			while ((entry = readdir(dir)) != nullptr)
+			int slot = static_cast<int>(cqe.user_data);
+			for (auto it = context.joystickDevices.begin(); it != context.joystickDevices.end(); ++it)
 			{
-				if (strncmp(entry->d_name, "event", 5) != 0)
+				if (it->uringSlot != slot)
 				{
 					continue;
 				}
 
-				std::string path = "/dev/input/" + std::string{ entry->d_name };
+				JoystickDevice& dev = *it;
+				dev.uringReadPending = false;
 
-				// Skip if already opened
-				if (IsJoystickDeviceAlreadyOpened(path))
+				if (!dev.opened)
 				{
-					continue;
+					// Closed while the read was in flight (see CloseJoystickDevice)
+					ReleaseIoUringSlot(context, slot);
+					CloseFd(context.counters, dev.fd);
+					context.joystickDevices.erase(it);
+					return;
 				}
 
-				int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK);
-				if (fd < 0)
+				if (cqe.res > 0)
 				{
-					continue;
-				}
+					KSMAXIS_TRACE_SCOPE(trace, "IoUringCompletion");
+					KSMAXIS_TRACE_LABEL(trace, dev.path);
+
+					const input_event* events = GetIoUringSlotBuffer(context, slot);
+					std::size_t count = static_cast<std::size_t>(cqe.res) / sizeof(input_event);
+					const std::int64_t readTimeNs = GetMonotonicTimeNs();
+					for (std::size_t i = 0; i < count; ++i)
+					{
+						ProcessJoystickEvent(dev.knobs, dev.timing, events[i], readTimeNs, context.activeModes, context.tickResampler);
+					}
+					QueueIoUringRead(context, dev);
+					dev.timing.AddEvents(count);
+					context.counters.AddEvents(count);
+					budget.AddEvents(count);
 
-				unsigned long evBits[(EV_CNT + kBitsPerLong - 1) / kBitsPerLong] = {};
-				if (ioctl(fd, EVIOCGBIT(0, sizeof(evBits)), evBits) < 0)
+					KSMAXIS_TRACE_ARG(trace, "events", count);
+				}
+				else if (cqe.res == 0 || cqe.res == -EAGAIN || cqe.res == -EINTR || cqe.res == -ECANCELED)
 				{
-					close(fd);
-					continue;
+					// Nothing read: the events were gone by the time the read ran, or the poll was cancelled while the
+					// device is still open (so not by CloseJoystickDevice). A disconnected device fails with -ENODEV.
+					QueueIoUringRead(context, dev);
 				}
-
-				bool hasAbs = evBits[EV_ABS / kBitsPerLong] & (1UL << (EV_ABS % kBitsPerLong));
-				if (!hasAbs)
+				else
 				{
-					close(fd);
-					continue;
+					// Disconnected (-ENODEV) or broken device
+					ReleaseIoUringSlot(context, slot);
+					CloseFd(context.counters, dev.fd);
+					context.joystickDevices.erase(it);
 				}
+				return;
+			}
 
-				JoystickDevice dev{};
-				dev.path = path;
-				dev.fd = fd;
+			ReleaseIoUringSlot(context, slot);
+		}
 
-				unsigned long absBits[(ABS_CNT + kBitsPerLong - 1) / kBitsPerLong] = {};
-				if (ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absBits)), absBits) >= 0)
-				{
-					for (int i = 0; i < ABS_CNT; ++i)
-					{
-						if (absBits[i / kBitsPerLong] & (1UL << (i % kBitsPerLong)))
-						{
-							struct input_absinfo absInfo{};
-							if (ioctl(fd, EVIOCGABS(i), &absInfo) >= 0)
-							{
-								dev.ranges[i].min = absInfo.minimum;
-								dev.ranges[i].max = absInfo.maximum;
-								dev.ranges[i].available = true;
-							}
-						}
-					}
-				}
+		unsigned HarvestIoUringCompletions(ContextImpl& context, UpdateBudgetScope& budget)
+		{
+			unsigned head = *context.ioUring.cqHead;
+			unsigned tail = std::atomic_ref<unsigned>{ *context.ioUring.cqTail }.load(std::memory_order_acquire);
+			unsigned count = 0;
 
-				dev.opened = true;
-				s_joystickDevices.push_back(std::move(dev));
+			// Completions left in the CQ ring when the budget runs out are harvested by the next Update()
+			while (head != tail && !budget.IsExhausted())
+			{
+				HandleIoUringCompletion(context, context.ioUring.cqes[head & *context.ioUring.cqRingMask], budget);
+				++head;
+				++count;
 			}
 
-			closedir(dir);
+			std::atomic_ref<unsigned>{ *context.ioUring.cqHead }.store(head, std::memory_order_release);
+			return count;
+		}
+
+		void UnmapIoUring(ContextImpl& context)
+		{
+			if (context.ioUring.sqes)
+			{
+				munmap(context.ioUring.sqes, context.ioUring.sqesSize);
+				context.counters.AddSyscalls(1);
+				context.ioUring.sqes = nullptr;
+			}
+			if (context.ioUring.cqRingPtr && context.ioUring.cqRingPtr != context.ioUring.sqRingPtr)
+			{
+				munmap(context.ioUring.cqRingPtr, context.ioUring.cqRingSize);
+				context.counters.AddSyscalls(1);
+			}
+			context.ioUring.cqRingPtr = nullptr;
+			if (context.ioUring.sqRingPtr)
+			{
+				munmap(context.ioUring.sqRingPtr, context.ioUring.sqRingSize);
+				context.counters.AddSyscalls(1);
+				context.ioUring.sqRingPtr = nullptr;
+			}
+			if (context.ioUring.ringFd >= 0)
+			{
+				CloseFd(context.counters, context.ioUring.ringFd);
+				context.ioUring.ringFd = -1;
+			}
 		}
 
-		bool InitX11Mouse(std::vector<std::string>* pWarningStrings)
+		bool InitIoUring(ContextImpl& context, std::vector<std::string>* pWarningStrings)
 		{
-			s_x11Mouse.display = XOpenDisplay(nullptr);
-			if (!s_x11Mouse.display)
+			if (context.ioUring.initialized)
+			{
+				return true;
+			}
+
+			KSMAXIS_TRACE_SCOPE(trace, "InitIoUring");
+
+			io_uring_params params{};
+			// Room for a poll and a read per slot, plus their two cancels on close
+			context.ioUring.ringFd = IoUringSetup(kIoUringMaxSlots * 4, &params);
+			context.counters.AddSyscalls(1);
+			if (context.ioUring.ringFd < 0)
 			{
 				if (pWarningStrings)
 				{
-					pWarningStrings->push_back("Failed to open X11 display");
+					pWarningStrings->push_back(std::string{ "io_uring unavailable, falling back to read(): " } + std::strerror(errno));
 				}
+				context.ioUring.ringFd = -1;
 				return false;
 			}
 
-			int xiEvent, xiError;
-			if (!XQueryExtension(s_x11Mouse.display, "XInputExtension", &s_x11Mouse.xiOpcode, &xiEvent, &xiError))
+			context.ioUring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			context.ioUring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (singleMmap)
+			{
+				context.ioUring.sqRingSize = context.ioUring.cqRingSize = std::max(context.ioUring.sqRingSize, context.ioUring.cqRingSize);
+			}
+
+			void* sqRingPtr = mmap(nullptr, context.ioUring.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, context.ioUring.ringFd, IORING_OFF_SQ_RING);
+			context.counters.AddSyscalls(1);
+			if (sqRingPtr == MAP_FAILED)
 			{
 				if (pWarningStrings)
 				{
-					pWarningStrings->push_back("XInput extension not available");
+					pWarningStrings->push_back("io_uring SQ ring mmap failed, falling back to read()");
 				}
-				XCloseDisplay(s_x11Mouse.display);
-				s_x11Mouse.display = nullptr;
+				UnmapIoUring(context);
 				return false;
 			}
+			context.ioUring.sqRingPtr = sqRingPtr;
 
-			int major = 2;
-			int minor = 2;
-			if (XIQueryVersion(s_x11Mouse.display, &major, &minor) != Success)
+			void* cqRingPtr = sqRingPtr;
+			if (!singleMmap)
+			{
+				cqRingPtr = mmap(nullptr, context.ioUring.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, context.ioUring.ringFd, IORING_OFF_CQ_RING);
+				context.counters.AddSyscalls(1);
+				if (cqRingPtr == MAP_FAILED)
+				{
+					if (pWarningStrings)
+					{
+						pWarningStrings->push_back("io_uring CQ ring mmap failed, falling back to read()");
+					}
+					UnmapIoUring(context);
+					return false;
+				}
+			}
+			context.ioUring.cqRingPtr = cqRingPtr;
+
+			context.ioUring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+			void* sqes = mmap(nullptr, context.ioUring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, context.ioUring.ringFd, IORING_OFF_SQES);
+			context.counters.AddSyscalls(1);
+			if (sqes == MAP_FAILED)
 			{
 				if (pWarningStrings)
 				{
-					pWarningStrings->push_back("XInput2 version 2.2 not available");
+					pWarningStrings->push_back("io_uring SQE array mmap failed, falling back to read()");
 				}
-				XCloseDisplay(s_x11Mouse.display);
-				s_x11Mouse.display = nullptr;
+				UnmapIoUring(context);
 				return false;
 			}
-
-			XIEventMask eventMask;
-			unsigned char maskData[XIMaskLen(XI_RawMotion)] = {};
-			XISetMask(maskData, XI_RawMotion);
-
-			eventMask.deviceid = XIAllMasterDevices;
-			eventMask.mask_len = sizeof(maskData);
-			eventMask.mask = maskData;
-
-			Window root = DefaultRootWindow(s_x11Mouse.display);
-			XISelectEvents(s_x11Mouse.display, root, &eventMask, 1);
-			XFlush(s_x11Mouse.display);
-
-			s_x11Mouse.initialized = true;
+			context.ioUring.sqes = static_cast<io_uring_sqe*>(sqes);
+
+			auto* sqBase = static_cast<char*>(sqRingPtr);
+			context.ioUring.sqEntries = params.sq_entries;
+			context.ioUring.sqHead = reinterpret_cast<unsigned*>(sqBase + params.sq_off.head);
+			context.ioUring.sqTail = reinterpret_cast<unsigned*>(sqBase + params.sq_off.tail);
+			context.ioUring.sqRingMask = reinterpret_cast<unsigned*>(sqBase + params.sq_off.ring_mask);
+			context.ioUring.sqArray = reinterpret_cast<unsigned*>(sqBase + params.sq_off.array);
+
+			auto* cqBase = static_cast<char*>(cqRingPtr);
+			context.ioUring.cqHead = reinterpret_cast<unsigned*>(cqBase + params.cq_off.head);
+			context.ioUring.cqTail = reinterpret_cast<unsigned*>(cqBase + params.cq_off.tail);
+			context.ioUring.cqRingMask = reinterpret_cast<unsigned*>(cqBase + params.cq_off.ring_mask);
+			context.ioUring.cqes = reinterpret_cast<io_uring_cqe*>(cqBase + params.cq_off.cqes);
+
+			// Registered buffers skip per-read page pinning; plain reads into the same arena still work without them
+			struct iovec iov{};
+			iov.iov_base = context.ioUring.buffers;
+			iov.iov_len = sizeof(context.ioUring.buffers);
+			context.ioUring.buffersRegistered = IoUringRegister(context.ioUring.ringFd, IORING_REGISTER_BUFFERS, &iov, 1) == 0;
+			context.counters.AddSyscalls(1);
+
+			context.ioUring.pendingSubmissions = 0;
+			std::fill(std::begin(context.ioUring.slotUsed), std::end(context.ioUring.slotUsed), false);
+			context.ioUring.failed = false;
+			context.ioUring.initialized = true;
 			return true;
 		}
 
-		void TerminateX11Mouse()
+		void TerminateIoUring(ContextImpl& context)
 		{
-			if (s_x11Mouse.display)
+			if (!context.ioUring.initialized)
 			{
-				XCloseDisplay(s_x11Mouse.display);
-				s_x11Mouse.display = nullptr;
+				return;
 			}
-			s_x11Mouse.initialized = false;
-			s_x11Mouse.xiOpcode = -1;
-			s_x11Mouse.deltaX = 0.0;
-			s_x11Mouse.deltaY = 0.0;
-		}
-	}
 
-	bool Init(DeviceFlags deviceFlags, std::string* pErrorString, std::vector<std::string>* pWarningStrings)
-	{
-		// Skip already initialized devices
-		deviceFlags = deviceFlags & ~s_initializedDevices;
-		if (deviceFlags == DeviceFlags::None)
-		{
-			return true;
-		}
+			// In-flight reads still reference the buffer arena, so cancel them and wait before unmapping. A read whose
+			// cancel finds no room even after submitting the queued SQEs is cancelled by closing the ring instead.
+			unsigned pendingReads = 0;
+			for (auto& dev : context.joystickDevices)
+			{
+				if (!dev.uringReadPending)
+				{
+					continue;
+				}
+				if (!QueueIoUringCancel(context, dev))
+				{
+					SubmitIoUring(context);
+					if (!QueueIoUringCancel(context, dev))
+					{
+						continue;
+					}
+				}
+				++pendingReads;
+			}
+
+			while (pendingReads > 0)
+			{
+				const int ret = IoUringEnter(context.ioUring.ringFd, context.ioUring.pendingSubmissions, 1, IORING_ENTER_GETEVENTS);
+				context.counters.AddSyscalls(1);
+				if (ret < 0 && errno != EINTR)
+				{
+					break;
+				}
+				context.ioUring.pendingSubmissions = 0;
+
+				unsigned head = *context.ioUring.cqHead;
+				unsigned tail = std::atomic_ref<unsigned>{ *context.ioUring.cqTail }.load(std::memory_order_acquire);
+				while (head != tail)
+				{
+					const io_uring_cqe& cqe = context.ioUring.cqes[head & *context.ioUring.cqRingMask];
+					if (cqe.user_data != kIoUringCancelUserData && (cqe.user_data & kIoUringPollUserDataFlag) == 0)
+					{
+						if (JoystickDevice* pDev = FindIoUringJoystickDevice(context, static_cast<int>(cqe.user_data)); pDev && pDev->uringReadPending)
+						{
+							pDev->uringReadPending = false;
+							--pendingReads;
+						}
+					}
+					++head;
+				}
+				std::atomic_ref<unsigned>{ *context.ioUring.cqHead }.store(head, std::memory_order_release);
+			}
 
-		s_firstUpdate = true;
-		s_lastScanTime = std::chrono::steady_clock::now();
+			for (auto& dev : context.joystickDevices)
+			{
+				dev.uringSlot = -1;
+				dev.uringReadPending = false;
+			}
 
-		if ((deviceFlags & DeviceFlags::Joystick) != DeviceFlags::None)
-		{
-			ScanJoystickDevices();
-			s_initializedDevices = s_initializedDevices | DeviceFlags::Joystick;
+			UnmapIoUring(context);
+			context.ioUring.buffersRegistered = false;
+			context.ioUring.pendingSubmissions = 0;
+			context.ioUring.failed = false;
+			context.ioUring.initialized = false;
 		}
 
-		if ((deviceFlags & DeviceFlags::Mouse) != DeviceFlags::None)
+		// Tears a failed ring down; every device is read with read() from then on
+		void FallBackFromIoUring(ContextImpl& context)
 		{
-			if (InitX11Mouse(pWarningStrings))
+			TerminateIoUring(context);
+
+			// Devices closed while their read was in flight (see CloseJoystickDevice) are no longer waited for
+			for (auto it = context.joystickDevices.begin(); it != context.joystickDevices.end();)
 			{
-				s_initializedDevices = s_initializedDevices | DeviceFlags::Mouse;
+				if (it->opened)
+				{
+					++it;
+					continue;
+				}
+				CloseFd(context.counters, it->fd);
+				it = context.joystickDevices.erase(it);
 			}
+			context.epollFdsChanged = true;
 		}
 
-		return true;
-	}
-
-	bool IsInitialized()
-	{
-		return s_initializedDevices != DeviceFlags::None;
-	}
-
-	bool IsInitialized(DeviceFlags deviceFlags)
-	{
-		return (s_initializedDevices & deviceFlags) == deviceFlags;
-	}
-
-	void Terminate()
-	{
-		for (auto& dev : s_joystickDevices)
+		void DrainIoUring(ContextImpl& context, UpdateBudgetScope& budget)
 		{
-			if (dev.fd >= 0)
+			if (!context.ioUring.initialized)
 			{
-				close(dev.fd);
-				dev.fd = -1;
+				return;
 			}
-		}
-		s_joystickDevices.clear();
 
-		TerminateX11Mouse();
+			KSMAXIS_TRACE_SCOPE(trace, "DrainIoUring");
 
-		s_initializedDevices = DeviceFlags::None;
-	}
-
-	void Update()
-	{
-		s_deltaAnalogStick = { 0.0, 0.0 };
-		s_deltaSlider = { 0.0, 0.0 };
-		s_deltaMouse = { 0.0, 0.0 };
+			// Re-posted reads complete inline when more data is already queued, so repeat while completions keep
+			// arriving to avoid leaving events behind until the next frame. SQEs left queued by a busy io_uring_enter()
+			// are retried here, after harvesting has made room in the CQ ring.
+			for (unsigned pass = 0; pass < kIoUringMaxDrainPasses && !context.ioUring.failed; ++pass)
+			{
+				if (HarvestIoUringCompletions(context, budget) == 0 && (pass > 0 || context.ioUring.pendingSubmissions == 0))
+				{
+					break;
+				}
+				SubmitIoUring(context);
+			}
 
-		if (s_initializedDevices == DeviceFlags::None)
-		{
-			return;
+			if (context.ioUring.failed)
+			{
+				FallBackFromIoUring(context);
+			}
 		}
+#endif
 
-		auto now = std::chrono::steady_clock::now();
-		auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - s_lastScanTime);
-		if (elapsed.count() >= 1000)
+		// Returns the position following the device, which stays in the list until its in-flight io_uring read is cancelled
+		JoystickDevice* CloseJoystickDevice(ContextImpl& context, JoystickDevice* it)
 		{
-			RemoveDisconnectedJoystickDevices();
-			ScanJoystickDevices();
-			s_lastScanTime = now;
+#ifdef KSMAXIS_LINUX_IO_URING
+			if (it->uringReadPending)
+			{
+				if (it->opened)
+				{
+					// With the SQ ring full, the read is left to complete with the next input or -ENODEV
+					if (QueueIoUringCancel(context, *it))
+					{
+						SubmitIoUring(context);
+					}
+					it->opened = false;
+					it->timing.Detach();
+				}
+				return it + 1;
+			}
+			ReleaseIoUringSlot(context, it->uringSlot);
+#endif
+			CloseFd(context.counters, it->fd);
+			return context.joystickDevices.erase(it);
 		}
 
-		for (auto& dev : s_joystickDevices)
+		bool IsJoystickDeviceAlreadyOpened(ContextImpl& context, const char* path)
 		{
-			if (!dev.opened || dev.fd < 0)
+			for (const auto& dev : context.joystickDevices)
 			{
-				continue;
+				if (std::strcmp(dev.path, path) == 0)
+				{
+					return true;
+				}
 			}
+			return false;
+		}
 
-			struct input_event ev{};
-			while (read(dev.fd, &ev, sizeof(ev)) == sizeof(ev))
+		void RemoveDisconnectedJoystickDevices(ContextImpl& context)
+		{
+			KSMAXIS_TRACE_SCOPE(trace, "RemoveDisconnectedJoystickDevices");
+
+			std::size_t removedCount = 0;
+			for (auto it = context.joystickDevices.begin(); it != context.joystickDevices.end();)
 			{
-				if (ev.type != EV_ABS)
+				if (!it->opened || it->fd < 0)
+				{
+					++it;
+					continue;
+				}
+
+#ifdef KSMAXIS_LINUX_IO_URING
+				// The pending read completes with -ENODEV and the device is removed on harvest
+				if (it->uringReadPending)
 				{
+					++it;
 					continue;
 				}
+#endif
+
+				struct input_id id;
+				context.counters.AddSyscalls(1);
+				if (ioctl(it->fd, EVIOCGID, &id) < 0)
+				{
+					it = CloseJoystickDevice(context, it);
+					++removedCount;
+				}
+				else
+				{
+					++it;
+				}
+			}
 
-				double normalized = Normalize(dev, ev.code, ev.value);
+			KSMAXIS_TRACE_ARG(trace, "removed", removedCount);
+		}
 
-				switch (ev.code)
+		bool IsClaimedByHidraw(ContextImpl& context, std::uint16_t vendorId, std::uint16_t productId)
+		{
+			for (const auto& dev : context.hidrawDevices)
+			{
+				if (dev.vendorId == vendorId && dev.productId == productId)
 				{
-				case ABS_X:
-					dev.axisX = normalized;
-					break;
-				case ABS_Y:
-					dev.axisY = normalized;
-					break;
-				case ABS_THROTTLE:
-				case ABS_MISC:
-					dev.slider0 = normalized;
-					break;
-				case ABS_RUDDER:
-					dev.slider1 = normalized;
-					break;
+					return true;
 				}
 			}
+			return false;
+		}
 
-			if (!s_firstUpdate)
+		bool HasHidrawAxisMapping(ContextImpl& context, std::uint16_t vendorId, std::uint16_t productId)
+		{
+			for (const auto& mapping : context.hidrawAxisMappings)
 			{
-				s_deltaAnalogStick[0] += CalculateDelta(dev.axisX, dev.prevAxisX);
-				s_deltaAnalogStick[1] += CalculateDelta(dev.axisY, dev.prevAxisY);
-				s_deltaSlider[0] += CalculateDelta(dev.slider0, dev.prevSlider0);
-				s_deltaSlider[1] += CalculateDelta(dev.slider1, dev.prevSlider1);
+				if (mapping.vendorId == vendorId && mapping.productId == productId)
+				{
+					return true;
+				}
 			}
+			return false;
+		}
 
-			dev.prevAxisX = dev.axisX;
-			dev.prevAxisY = dev.axisY;
-			dev.prevSlider0 = dev.slider0;
-			dev.prevSlider1 = dev.slider1;
+		const HidrawAxisMapping* FindHidrawAxisMapping(ContextImpl& context, std::uint16_t vendorId, std::uint16_t productId, std::uint32_t usagePage, std::uint32_t usage)
+		{
+			for (const auto& mapping : context.hidrawAxisMappings)
+			{
+				if (mapping.vendorId == vendorId && mapping.productId == productId && mapping.usagePage == usagePage && mapping.usage == usage)
+				{
+					return &mapping;
+				}
+			}
+			return nullptr;
 		}
 
-		if (s_x11Mouse.initialized && s_x11Mouse.display)
+		bool AddHidrawField(HidrawDevice& dev, const HidrawAxisMapping& mapping, std::uint8_t reportId, std::uint32_t bitOffset, std::uint32_t bitSize, std::int32_t logicalMin, std::int32_t logicalMax)
 		{
-			s_x11Mouse.deltaX = 0.0;
-			s_x11Mouse.deltaY = 0.0;
+			if (dev.fieldCount >= kMaxHidrawFields || bitSize == 0 || bitSize > 32 || mapping.axisIndex > 1)
+			{
+				return false;
+			}
 
-			while (XPending(s_x11Mouse.display) > 0)
+			HidrawAxis axis;
+			if (mapping.mode == InputMode::kAnalogStick)
 			{
-				XEvent event;
-				XNextEvent(s_x11Mouse.display, &event);
+				axis = mapping.axisIndex == 0 ? kHidrawAxisX : kHidrawAxisY;
+			}
+			else if (mapping.mode == InputMode::kSlider)
+			{
+				axis = mapping.axisIndex == 0 ? kHidrawSlider0 : kHidrawSlider1;
+			}
+			else
+			{
+				return false;
+			}
 
-				XGenericEventCookie* cookie = &event.xcookie;
-				if (cookie->type == GenericEvent && cookie->extension == s_x11Mouse.xiOpcode && XGetEventData(s_x11Mouse.display, cookie))
+			HidrawField& field = dev.fields[dev.fieldCount++];
+			field.reportId = reportId;
+			field.byteOffset = bitOffset / 8;
+			field.shift = bitOffset % 8;
+			field.byteCount = (field.shift + bitSize + 7) / 8;
+			field.mask = bitSize == 32 ? 0xFFFFFFFFu : ((1u << bitSize) - 1u);
+			field.signBit = logicalMin < 0 ? (1u << (bitSize - 1)) : 0u;
+			field.axis = axis;
+
+			// Fall back to the raw bit range when the descriptor declares no usable logical range
+			if (logicalMax > logicalMin)
+			{
+				field.logicalMin = logicalMin;
+				field.logicalMax = logicalMax;
+			}
+			else
+			{
+				field.logicalMin = 0;
+				field.logicalMax = static_cast<std::int32_t>(std::min<std::uint32_t>(field.mask, INT32_MAX));
+				field.signBit = 0;
+			}
+			return true;
+		}
+
+		// Walks the short items of a HID report descriptor and compiles an extractor for each mapped input field
+		void ParseHidReportDescriptor(ContextImpl& context, HidrawDevice& dev, const std::uint8_t* desc, std::size_t size)
+		{
+			struct GlobalState
+			{
+				std::uint32_t usagePage = 0;
+				std::int32_t logicalMin = 0;
+				std::int32_t logicalMax = 0;
+				std::uint32_t reportSize = 0;
+				std::uint32_t reportCount = 0;
+				std::uint8_t reportId = 0;
+			};
+
+			GlobalState global{};
+			GlobalState globalStack[kHidGlobalStackDepth];
+			std::size_t globalStackDepth = 0;
+
+			std::uint32_t usages[kHidMaxUsages] = {};
+			std::size_t usageCount = 0;
+			std::uint32_t usageMin = 0;
+			std::uint32_t usageMax = 0;
+			bool hasUsageRange = false;
+
+			std::uint32_t reportBitOffsets[256] = {};
+
+			std::size_t pos = 0;
+			while (pos < size)
+			{
+				const std::uint8_t prefix = desc[pos++];
+
+				// Long item (unused by real devices); skip its payload
+				if (prefix == 0xFE)
 				{
-					if (cookie->evtype == XI_RawMotion)
+					if (pos + 1 >= size)
 					{
-						XIRawEvent* rawEvent = reinterpret_cast<XIRawEvent*>(cookie->data);
-						double* rawValues = rawEvent->raw_values;
+						break;
+					}
+					pos += 2 + desc[pos];
+					continue;
+				}
 
-						if (XIMaskIsSet(rawEvent->valuators.mask, 0))
+				const std::size_t dataSize = (prefix & 0x3) == 3 ? 4 : (prefix & 0x3);
+				const std::uint8_t type = (prefix >> 2) & 0x3;
+				const std::uint8_t tag = prefix >> 4;
+				if (pos + dataSize > size)
+				{
+					break;
+				}
+
+				std::uint32_t data = 0;
+				for (std::size_t i = 0; i < dataSize; ++i)
+				{
+					data |= static_cast<std::uint32_t>(desc[pos + i]) << (8 * i);
+				}
+				std::int32_t signedData = static_cast<std::int32_t>(data);
+				if (dataSize == 1)
+				{
+					signedData = static_cast<std::int8_t>(data);
+				}
+				else if (dataSize == 2)
+				{
+					signedData = static_cast<std::int16_t>(data);
+				}
+				pos += dataSize;
+
+				// Usages declared with 4 bytes carry their own usage page in the high half
+				const auto toFullUsage = [&](std::uint32_t value)
+				{
+					return dataSize == 4 ? value : ((global.usagePage << 16) | (value & 0xFFFF));
+				};
+
+				if (type == 0) // Main
+				{
+					if (tag == 0x8) // Input
+					{
+						const bool isConstant = (data & 0x1) != 0;
+						const bool isVariable = (data & 0x2) != 0;
+						std::uint32_t& bitOffset = reportBitOffsets[global.reportId];
+
+						for (std::uint32_t i = 0; i < global.reportCount; ++i)
 						{
-							s_x11Mouse.deltaX += *rawValues;
-							rawValues++;
+							std::uint32_t usage = 0;
+							bool hasUsage = false;
+							if (usageCount > 0)
+							{
+								usage = usages[std::min<std::size_t>(i, usageCount - 1)];
+								hasUsage = true;
+							}
+							else if (hasUsageRange)
+							{
+								usage = std::min(usageMin + i, usageMax);
+								hasUsage = true;
+							}
+
+							if (!isConstant && isVariable && hasUsage)
+							{
+								const HidrawAxisMapping* pMapping = FindHidrawAxisMapping(context, dev.vendorId, dev.productId, usage >> 16, usage & 0xFFFF);
+								if (pMapping)
+								{
+									AddHidrawField(dev, *pMapping, global.reportId, bitOffset, global.reportSize, global.logicalMin, global.logicalMax);
+								}
+							}
+							bitOffset += global.reportSize;
 						}
-						if (XIMaskIsSet(rawEvent->valuators.mask, 1))
+					}
+
+					// Local items only apply to the next main item
+					usageCount = 0;
+					hasUsageRange = false;
+				}
+				else if (type == 1) // Global
+				{
+					switch (tag)
+					{
+					case 0x0:
+						global.usagePage = data;
+						break;
+					case 0x1:
+						global.logicalMin = signedData;
+						break;
+					case 0x2:
+						// A non-negative minimum means the maximum is unsigned as well
+						global.logicalMax = global.logicalMin >= 0 ? static_cast<std::int32_t>(std::min<std::uint32_t>(data, INT32_MAX)) : signedData;
+						break;
+					case 0x7:
+						global.reportSize = data;
+						break;
+					case 0x8:
+						global.reportId = static_cast<std::uint8_t>(data);
+						dev.usesReportIds = true;
+						break;
+					case 0x9:
+						global.reportCount = data;
+						break;
+					case 0xA:
+						if (globalStackDepth < kHidGlobalStackDepth)
+						{
+							globalStack[globalStackDepth++] = global;
+						}
+						break;
+					case 0xB:
+						if (globalStackDepth > 0)
+						{
+							global = globalStack[--globalStackDepth];
+						}
+						break;
+					}
+				}
+				else if (type == 2) // Local
+				{
+					switch (tag)
+					{
+					case 0x0:
+						if (usageCount < kHidMaxUsages)
 						{
-							s_x11Mouse.deltaY += *rawValues;
+							usages[usageCount++] = toFullUsage(data);
 						}
+						break;
+					case 0x1:
+						usageMin = toFullUsage(data);
+						hasUsageRange = true;
+						break;
+					case 0x2:
+						usageMax = toFullUsage(data);
+						hasUsageRange = true;
+						break;
 					}
-					XFreeEventData(s_x11Mouse.display, cookie);
 				}
 			}
+		}
+
+		void ApplyHidrawReport(HidrawDevice& dev, const std::uint8_t* report, std::size_t size, InputModeSet modes, std::int64_t readTimeNs, TickResampler& resampler)
+		{
+			std::uint8_t reportId = 0;
+			if (dev.usesReportIds)
+			{
+				if (size == 0)
+				{
+					return;
+				}
+				reportId = report[0];
+				++report;
+				--size;
+			}
+
+			double reportDeltas[kHidrawAxisCount] = {};
+			for (std::size_t i = 0; i < dev.fieldCount; ++i)
+			{
+				HidrawField& field = dev.fields[i];
+				if (field.reportId != reportId || field.byteOffset + field.byteCount > size)
+				{
+					continue;
+				}
+
+				std::uint64_t bits = 0;
+				for (std::uint32_t b = 0; b < field.byteCount; ++b)
+				{
+					bits |= static_cast<std::uint64_t>(report[field.byteOffset + b]) << (8 * b);
+				}
+				const std::uint32_t raw = static_cast<std::uint32_t>(bits >> field.shift) & field.mask;
+
+				std::int64_t value = raw;
+				if (field.signBit != 0 && (raw & field.signBit) != 0)
+				{
+					value -= static_cast<std::int64_t>(field.mask) + 1;
+				}
+
+				// logicalMin~logicalMax -> 0.0~1.0
+				const double normalized = static_cast<double>(value - field.logicalMin) / static_cast<double>(static_cast<std::int64_t>(field.logicalMax) - field.logicalMin);
+				const InputMode mode = (field.axis == kHidrawAxisX || field.axis == kHidrawAxisY) ? InputMode::kAnalogStick : InputMode::kSlider;
+				if (field.hasValue && modes.Contains(mode))
+				{
+					reportDeltas[field.axis] += CalculateDelta(normalized, field.value);
+				}
+				field.value = normalized;
+				field.hasValue = true;
+			}
 
-			s_deltaMouse[0] = s_x11Mouse.deltaX;
-			s_deltaMouse[1] = s_x11Mouse.deltaY;
+			for (std::size_t axis = 0; axis < kHidrawAxisCount; ++axis)
+			{
+				dev.deltas[axis] += reportDeltas[axis];
+			}
+			resampler.Add(InputMode::kAnalogStick, readTimeNs, reportDeltas[kHidrawAxisX], reportDeltas[kHidrawAxisY]);
+			resampler.Add(InputMode::kSlider, readTimeNs, reportDeltas[kHidrawSlider0], reportDeltas[kHidrawSlider1]);
 		}
 
-		s_firstUpdate = false;
-	}
+		// Closes evdev nodes of a device that the hidraw backend has taken over
+		void CloseJoystickDevicesClaimedByHidraw(ContextImpl& context, std::uint16_t vendorId, std::uint16_t productId)
+		{
+			for (auto it = context.joystickDevices.begin(); it != context.joystickDevices.end();)
+			{
+				if (it->opened && it->vendorId == vendorId && it->productId == productId)
+				{
+					it = CloseJoystickDevice(context, it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
 
-	AxisValues GetAxisDeltas(InputMode mode)
-	{
-		if (mode == InputMode::kAnalogStick)
+		bool IsHidrawDeviceAlreadyOpened(ContextImpl& context, const char* path)
 		{
-			return s_deltaAnalogStick;
+			for (const auto& dev : context.hidrawDevices)
+			{
+				if (std::strcmp(dev.path, path) == 0)
+				{
+					return true;
+				}
+			}
+			return false;
 		}
-		else if (mode == InputMode::kMouse)
+
+		bool OpenHidrawDevice(ContextImpl& context, const char* name)
+		{
+			if (strncmp(name, "hidraw", 6) != 0)
+			{
+				return false;
+			}
+
+			constexpr std::size_t kDirPathLength = sizeof(kDevDirPath) - 1;
+			const std::size_t nameLength = std::strlen(name);
+			if (kDirPathLength + nameLength >= kDevicePathSize)
+			{
+				return false;
+			}
+
+			char path[kDevicePathSize];
+			std::memcpy(path, kDevDirPath, kDirPathLength);
+			std::memcpy(path + kDirPathLength, name, nameLength + 1);
+
+			if (IsHidrawDeviceAlreadyOpened(context, path) || context.hidrawDevices.full())
+			{
+				return false;
+			}
+
+			int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+			context.counters.AddSyscalls(1);
+			if (fd < 0)
+			{
+				return false;
+			}
+
+			struct hidraw_devinfo info{};
+			context.counters.AddSyscalls(1);
+			if (ioctl(fd, HIDIOCGRAWINFO, &info) < 0)
+			{
+				CloseFd(context.counters, fd);
+				return false;
+			}
+
+			const auto vendorId = static_cast<std::uint16_t>(info.vendor);
+			const auto productId = static_cast<std::uint16_t>(info.product);
+			if (!HasHidrawAxisMapping(context, vendorId, productId))
+			{
+				CloseFd(context.counters, fd);
+				return false;
+			}
+
+			int descriptorSize = 0;
+			struct hidraw_report_descriptor descriptor{};
+			context.counters.AddSyscalls(1);
+			if (ioctl(fd, HIDIOCGRDESCSIZE, &descriptorSize) < 0 || descriptorSize <= 0)
+			{
+				CloseFd(context.counters, fd);
+				return false;
+			}
+			descriptor.size = static_cast<std::uint32_t>(std::min(descriptorSize, HID_MAX_DESCRIPTOR_SIZE));
+			context.counters.AddSyscalls(1);
+			if (ioctl(fd, HIDIOCGRDESC, &descriptor) < 0)
+			{
+				CloseFd(context.counters, fd);
+				return false;
+			}
+
+			HidrawDevice dev{};
+			std::memcpy(dev.path, path, sizeof(path));
+			ioctl(fd, HIDIOCGRAWNAME(sizeof(dev.name) - 1), dev.name);
+			context.counters.AddSyscalls(1);
+			dev.fd = fd;
+			dev.vendorId = vendorId;
+			dev.productId = productId;
+			ParseHidReportDescriptor(context, dev, descriptor.value, descriptor.size);
+
+			// Interfaces of the device without mapped fields (e.g. its keyboard part) stay closed
+			if (dev.fieldCount == 0)
+			{
+				CloseFd(context.counters, fd);
+				return false;
+			}
+
+			dev.timing.Attach(context.deviceCounters);
+			context.hidrawDevices.push_back(std::move(dev));
+			context.epollFdsChanged = true;
+			CloseJoystickDevicesClaimedByHidraw(context, vendorId, productId);
+			return true;
+		}
+
+		void ScanHidrawDevices(ContextImpl& context)
 		{
-			return s_deltaMouse;
+			if (context.hidrawAxisMappings.empty())
+			{
+				return;
+			}
+
+			KSMAXIS_TRACE_SCOPE(trace, "ScanHidrawDevices");
+
+			// /sys/class/hidraw lists only hidraw nodes, unlike /dev
+			if (context.hidrawClassDirFd < 0)
+			{
+				context.hidrawClassDirFd = open(kHidrawClassDirPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				context.counters.AddSyscalls(1);
+				if (context.hidrawClassDirFd < 0)
+				{
+					return;
+				}
+			}
+
+			context.counters.AddSyscalls(1);
+			if (lseek(context.hidrawClassDirFd, 0, SEEK_SET) < 0)
+			{
+				return;
+			}
+
+			std::size_t openedCount = 0;
+			alignas(LinuxDirent64) char buffer[kDirentBufferSize];
+			long bytesRead;
+			while ((bytesRead = syscall(SYS_getdents64, context.hidrawClassDirFd, buffer, sizeof(buffer))) > 0)
+			{
+				context.counters.AddSyscalls(1);
+				for (long pos = 0; pos < bytesRead;)
+				{
+					const auto* entry = reinterpret_cast<const LinuxDirent64*>(buffer + pos);
+					const char* name = buffer + pos + offsetof(LinuxDirent64, name);
+					pos += entry->reclen;
+
+					if (OpenHidrawDevice(context, name))
+					{
+						++openedCount;
+					}
+				}
+			}
+
+			context.counters.AddSyscalls(1); // The getdents64() that ended the loop
+			KSMAXIS_TRACE_ARG(trace, "opened", openedCount);
 		}
-		else
+
+		// Returns false if the device is gone (-EIO/-ENODEV)
+		bool DrainHidrawDevice(ContextImpl& context, HidrawDevice& dev, UpdateBudgetScope& budget)
 		{
-			return s_deltaSlider;
+			KSMAXIS_TRACE_SCOPE(trace, "DrainHidrawDevice");
+			KSMAXIS_TRACE_LABEL(trace, dev.path);
+
+			// hidraw returns exactly one report per read()
+			std::size_t reportCount = 0;
+			std::size_t readCount = 0;
+			int readError = 0;
+			std::uint8_t report[kHidrawReportBufferSize];
+			while (!budget.IsExhausted())
+			{
+				const ssize_t size = read(dev.fd, report, sizeof(report));
+				++readCount;
+				if (size <= 0)
+				{
+					readError = size < 0 ? errno : 0;
+					break;
+				}
+
+				// No kernel timestamp on hidraw, so intervals are measured at read time
+				const std::int64_t readTimeNs = GetMonotonicTimeNs();
+				dev.timing.AddReport(readTimeNs, -1);
+				ApplyHidrawReport(dev, report, static_cast<std::size_t>(size), context.activeModes, readTimeNs, context.tickResampler);
+				budget.AddEvents(1);
+				++reportCount;
+			}
+
+			dev.timing.AddEvents(reportCount);
+			context.counters.AddEvents(reportCount);
+			context.counters.AddSyscalls(readCount);
+
+			KSMAXIS_TRACE_ARG(trace, "reports", reportCount);
+
+			return readError == 0 || readError == EAGAIN || readError == EINTR;
 		}
+
+		void TerminateHidrawDevices(ContextImpl& context)
+		{
+			for (auto& dev : context.hidrawDevices)
+			{
+				if (dev.fd >= 0)
+				{
+					CloseFd(context.counters, dev.fd);
+					dev.fd = -1;
+				}
+			}
+			context.hidrawDevices.clear();
+
+			if (context.hidrawClassDirFd >= 0)
+			{
+				CloseFd(context.counters, context.hidrawClassDirFd);
+				context.hidrawClassDirFd = -1;
+			}
+		}
+
+		// Returns -1 unless name is "event<N>"
+		int ParseEventNodeNumber(const char* name)
+		{
+			if (std::strncmp(name, "event", 5) != 0 || name[5] == '\0')
+			{
+				return -1;
+			}
+
+			int number = 0;
+			for (const char* p = name + 5; *p != '\0'; ++p)
+			{
+				if (*p < '0' || *p > '9' || number > INT_MAX / 10 - 1)
+				{
+					return -1;
+				}
+				number = number * 10 + (*p - '0');
+			}
+			return number;
+		}
+
+		// Reads a small text file into buffer. Returns false if it is missing or doesn't fit.
+		bool ReadTextFileAt(UpdateCounters& counters, int dirFd, const char* path, char* buffer, std::size_t bufferSize)
+		{
+			const int fd = openat(dirFd, path, O_RDONLY | O_CLOEXEC);
+			counters.AddSyscalls(1);
+			if (fd < 0)
+			{
+				return false;
+			}
+
+			std::size_t length = 0;
+			bool complete = false;
+			while (length + 1 < bufferSize)
+			{
+				const ssize_t size = read(fd, buffer + length, bufferSize - 1 - length);
+				counters.AddSyscalls(1);
+				if (size <= 0)
+				{
+					complete = size == 0;
+					break;
+				}
+				length += static_cast<std::size_t>(size);
+			}
+			CloseFd(counters, fd);
+
+			buffer[length] = '\0';
+			return complete;
+		}
+
+		// Parses a sysfs capability bitmap: hex words separated by spaces, most significant first
+		bool ParseCapabilityBitmap(const char* text, unsigned long* bits, std::size_t wordCount)
+		{
+			std::fill(bits, bits + wordCount, 0UL);
+
+			const char* end = text + std::strlen(text);
+			std::size_t word = 0;
+			while (true)
+			{
+				while (end > text && (end[-1] == ' ' || end[-1] == '\n'))
+				{
+					--end;
+				}
+				if (end == text)
+				{
+					break;
+				}
+
+				const char* begin = end;
+				while (begin > text && begin[-1] != ' ')
+				{
+					--begin;
+				}
+
+				// Words beyond wordCount only hold codes above the ones asked for
+				if (word < wordCount)
+				{
+					char* parseEnd = nullptr;
+					bits[word] = std::strtoul(begin, &parseEnd, 16);
+					if (parseEnd == begin)
+					{
+						return false;
+					}
+				}
+				++word;
+				end = begin;
+			}
+			return word > 0;
+		}
+
+		std::size_t CountKnobAxes(const unsigned long* absBits)
+		{
+			std::size_t count = 0;
+			for (const int code : kKnobAbsCodes)
+			{
+				if (absBits[code / kBitsPerLong] & (1UL << (code % kBitsPerLong)))
+				{
+					++count;
+				}
+			}
+			return count;
+		}
+
+		bool HasKnobAxis(const unsigned long* absBits)
+		{
+			return CountKnobAxes(absBits) > 0;
+		}
+
+		enum class InputNodeClass : std::uint8_t
+		{
+			kUnknown, // No classification available; probe by opening the node
+			kKnob,
+			kOther,
+		};
+
+		// ID_INPUT_* properties udev stored for the node. Joysticks are opened without reading sysfs; sensors and
+		// touch devices also report absolute X/Y, but are never knobs.
+		InputNodeClass ClassifyInputNodeFromUdev(ContextImpl& context, const char* name)
+		{
+			if (context.udevDataDirFd < 0 || context.inputDirFd < 0)
+			{
+				return InputNodeClass::kUnknown;
+			}
+
+			struct stat st{};
+			context.counters.AddSyscalls(1);
+			if (fstatat(context.inputDirFd, name, &st, 0) < 0 || !S_ISCHR(st.st_mode))
+			{
+				return InputNodeClass::kUnknown;
+			}
+
+			char dataName[32];
+			std::snprintf(dataName, sizeof(dataName), "c%u:%u", major(st.st_rdev), minor(st.st_rdev));
+
+			char data[kUdevDataBufferSize];
+			if (!ReadTextFileAt(context.counters, context.udevDataDirFd, dataName, data, sizeof(data)))
+			{
+				return InputNodeClass::kUnknown;
+			}
+
+			constexpr const char* kNonKnobProperties[] = {
+				"E:ID_INPUT_ACCELEROMETER=1",
+				"E:ID_INPUT_TOUCHPAD=1",
+				"E:ID_INPUT_TOUCHSCREEN=1",
+				"E:ID_INPUT_TABLET=1",
+			};
+
+			bool isJoystick = false;
+			bool isNonKnob = false;
+			for (char* line = data; *line != '\0';)
+			{
+				char* lineEnd = std::strchr(line, '\n');
+				if (lineEnd)
+				{
+					*lineEnd = '\0';
+				}
+
+				if (std::strcmp(line, "E:ID_INPUT_JOYSTICK=1") == 0)
+				{
+					isJoystick = true;
+				}
+				for (const char* property : kNonKnobProperties)
+				{
+					if (std::strcmp(line, property) == 0)
+					{
+						isNonKnob = true;
+					}
+				}
+
+				if (!lineEnd)
+				{
+					break;
+				}
+				line = lineEnd + 1;
+			}
+
+			if (isJoystick)
+			{
+				return InputNodeClass::kKnob;
+			}
+			return isNonKnob ? InputNodeClass::kOther : InputNodeClass::kUnknown;
+		}
+
+		InputNodeClass ClassifyInputNodeFromSysfs(ContextImpl& context, const char* name)
+		{
+			if (context.inputClassDirFd < 0)
+			{
+				return InputNodeClass::kUnknown;
+			}
+
+			char capabilitiesPath[kDevicePathSize];
+			if (std::snprintf(capabilitiesPath, sizeof(capabilitiesPath), "%s/device/capabilities/abs", name) >= static_cast<int>(sizeof(capabilitiesPath)))
+			{
+				return InputNodeClass::kUnknown;
+			}
+
+			char text[kSysfsFileBufferSize];
+			unsigned long absBits[(ABS_CNT + kBitsPerLong - 1) / kBitsPerLong];
+			if (!ReadTextFileAt(context.counters, context.inputClassDirFd, capabilitiesPath, text, sizeof(text)) ||
+				!ParseCapabilityBitmap(text, absBits, std::size(absBits)))
+			{
+				return InputNodeClass::kUnknown;
+			}
+
+			return HasKnobAxis(absBits) ? InputNodeClass::kKnob : InputNodeClass::kOther;
+		}
+
+		void RememberRejectedEventNode(ContextImpl& context, int eventNumber)
+		{
+			if (eventNumber >= 0 && static_cast<std::size_t>(eventNumber) < kMaxRejectedEventNodes)
+			{
+				context.rejectedEventNodes.set(static_cast<std::size_t>(eventNumber));
+			}
+		}
+
+		// Decides from udev and sysfs, without opening the node, whether it may have knob axes
+		bool MayHaveKnobAxes(ContextImpl& context, const char* name, int eventNumber)
+		{
+			if (eventNumber >= 0 && static_cast<std::size_t>(eventNumber) < kMaxRejectedEventNodes && context.rejectedEventNodes.test(static_cast<std::size_t>(eventNumber)))
+			{
+				return false;
+			}
+
+			InputNodeClass nodeClass = ClassifyInputNodeFromUdev(context, name);
+			if (nodeClass == InputNodeClass::kUnknown)
+			{
+				nodeClass = ClassifyInputNodeFromSysfs(context, name);
+			}
+
+			if (nodeClass == InputNodeClass::kOther)
+			{
+				RememberRejectedEventNode(context, eventNumber);
+				return false;
+			}
+			return true;
+		}
+
+		// Interfaces of one USB device share a phys path up to "/inputN" (the interface number); Bluetooth devices
+		// share the adapter's phys, so the uniq string (the device address) is part of the key. Without a phys
+		// path, the sysfs path is cut at the USB interface ("<port>:<config>.<interface>"). Virtual devices have
+		// neither and are left ungrouped (empty key).
+		void ReadPhysicalDeviceKey(ContextImpl& context, int fd, const char* name, char* key, std::size_t keySize)
+		{
+			key[0] = '\0';
+
+			char phys[kPhysicalDeviceKeySize] = {};
+			context.counters.AddSyscalls(1);
+			if (ioctl(fd, EVIOCGPHYS(sizeof(phys) - 1), phys) > 0 && phys[0] != '\0')
+			{
+				char* suffix = std::strrchr(phys, '/');
+				if (suffix && std::strncmp(suffix, "/input", 6) == 0 && suffix[6] != '\0' &&
+					std::strspn(suffix + 6, "0123456789") == std::strlen(suffix + 6))
+				{
+					*suffix = '\0';
+				}
+
+				char uniq[kPhysicalDeviceKeySize] = {};
+				ioctl(fd, EVIOCGUNIQ(sizeof(uniq) - 1), uniq);
+				context.counters.AddSyscalls(1);
+				std::snprintf(key, keySize, "phys:%s|%s", phys, uniq);
+				return;
+			}
+
+			if (context.inputClassDirFd < 0)
+			{
+				return;
+			}
+
+			// e.g. "../../devices/pci0000:00/0000:00:14.0/usb3/3-1/3-1:1.0/0003:1CCF:101C.0001/input/input5/event3"
+			char sysfsPath[kPhysicalDeviceKeySize * 2];
+			const ssize_t length = readlinkat(context.inputClassDirFd, name, sysfsPath, sizeof(sysfsPath) - 1);
+			context.counters.AddSyscalls(1);
+			if (length <= 0)
+			{
+				return;
+			}
+			sysfsPath[length] = '\0';
+
+			for (char* segment = std::strchr(sysfsPath, '/'); segment; segment = std::strchr(segment + 1, '/'))
+			{
+				unsigned config = 0;
+				unsigned interfaceNumber = 0;
+				int consumed = 0;
+				const char* colon = std::strchr(segment + 1, ':');
+				const char* segmentEnd = std::strchr(segment + 1, '/');
+				if (colon && (!segmentEnd || colon < segmentEnd) &&
+					std::sscanf(colon, ":%u.%u%n", &config, &interfaceNumber, &consumed) == 2 &&
+					(colon[consumed] == '/' || colon[consumed] == '\0'))
+				{
+					*segment = '\0';
+					std::snprintf(key, keySize, "sysfs:%s", sysfsPath);
+					return;
+				}
+			}
+		}
+
+		bool IsSuppressedEventNode(ContextImpl& context, const char* path)
+		{
+			for (const auto& node : context.suppressedEventNodes)
+			{
+				if (std::strcmp(node.path, path) == 0)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void RememberSuppressedEventNode(ContextImpl& context, const char* path, const char* keptPath)
+		{
+			SuppressedEventNode node{};
+			std::memcpy(node.path, path, kDevicePathSize);
+			std::memcpy(node.keptPath, keptPath, kDevicePathSize);
+			context.suppressedEventNodes.push_back(std::move(node));
+		}
+
+		JoystickDevice* FindJoystickSibling(ContextImpl& context, const char* physicalKey, const input_id& id)
+		{
+			if (physicalKey[0] == '\0')
+			{
+				return nullptr;
+			}
+
+			for (auto& dev : context.joystickDevices)
+			{
+				if (dev.opened && dev.vendorId == id.vendor && dev.productId == id.product && std::strcmp(dev.physicalKey, physicalKey) == 0)
+				{
+					return &dev;
+				}
+			}
+			return nullptr;
+		}
+
+		// A grab is released by the kernel when the fd is closed, including when the process dies
+		void SetJoystickDeviceGrab(ContextImpl& context, JoystickDevice& dev, bool grab)
+		{
+			if (dev.fd < 0 || dev.grabbed == grab)
+			{
+				return;
+			}
+
+			context.counters.AddSyscalls(1);
+			// Fails with EBUSY if another process holds the grab; the device is then read shared
+			if (ioctl(dev.fd, EVIOCGRAB, grab ? 1 : 0) >= 0)
+			{
+				dev.grabbed = grab;
+			}
+		}
+
+		bool OpenJoystickDevice(ContextImpl& context, const char* name)
+		{
+			const int eventNumber = ParseEventNodeNumber(name);
+			if (eventNumber < 0)
+			{
+				return false;
+			}
+
+			constexpr std::size_t kDirPathLength = sizeof(kInputDirPath) - 1;
+			const std::size_t nameLength = std::strlen(name);
+			if (kDirPathLength + nameLength >= kDevicePathSize)
+			{
+				return false;
+			}
+
+			char path[kDevicePathSize];
+			std::memcpy(path, kInputDirPath, kDirPathLength);
+			std::memcpy(path + kDirPathLength, name, nameLength + 1);
+
+			// Skip if already opened, or left closed in favor of a sibling interface
+			if (IsJoystickDeviceAlreadyOpened(context, path) || IsSuppressedEventNode(context, path))
+			{
+				return false;
+			}
+
+			if (context.joystickDevices.full())
+			{
+				return false;
+			}
+
+			// Opening is slow for some devices and fails noisily on locked-down systems, so skip nodes udev or sysfs rule out
+			if (!MayHaveKnobAxes(context, name, eventNumber))
+			{
+				return false;
+			}
+
+			// O_CLOEXEC so that a child process can't keep an exclusive grab alive after this one exits
+			int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+			context.counters.AddSyscalls(1);
+			if (fd < 0)
+			{
+				return false;
+			}
+
+			unsigned long evBits[(EV_CNT + kBitsPerLong - 1) / kBitsPerLong] = {};
+			context.counters.AddSyscalls(1);
+			if (ioctl(fd, EVIOCGBIT(0, sizeof(evBits)), evBits) < 0)
+			{
+				CloseFd(context.counters, fd);
+				return false;
+			}
+
+			bool hasAbs = evBits[EV_ABS / kBitsPerLong] & (1UL << (EV_ABS % kBitsPerLong));
+			unsigned long absBits[(ABS_CNT + kBitsPerLong - 1) / kBitsPerLong] = {};
+			context.counters.AddSyscalls(hasAbs ? 1 : 0);
+			if (!hasAbs || ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(absBits)), absBits) < 0 || !HasKnobAxis(absBits))
+			{
+				CloseFd(context.counters, fd);
+				RememberRejectedEventNode(context, eventNumber);
+				return false;
+			}
+
+			struct input_id id{};
+			ioctl(fd, EVIOCGID, &id);
+			context.counters.AddSyscalls(1);
+			if (IsClaimedByHidraw(context, id.vendor, id.product))
+			{
+				CloseFd(context.counters, fd);
+				return false;
+			}
+
+			// Only one interface per physical device is read, so that a knob reported on two interfaces
+			// isn't counted twice. The one with more knob axes is kept (the first one opened on a tie).
+			char physicalKey[kPhysicalDeviceKeySize];
+			ReadPhysicalDeviceKey(context, fd, name, physicalKey, sizeof(physicalKey));
+			const std::size_t knobAxisCount = CountKnobAxes(absBits);
+			if (JoystickDevice* sibling = FindJoystickSibling(context, physicalKey, id))
+			{
+				if (sibling->knobAxisCount >= knobAxisCount)
+				{
+					RememberSuppressedEventNode(context, path, sibling->path);
+					CloseFd(context.counters, fd);
+					return false;
+				}
+				RememberSuppressedEventNode(context, sibling->path, path);
+				CloseJoystickDevice(context, sibling);
+			}
+
+			JoystickDevice dev{};
+			std::memcpy(dev.path, path, sizeof(path));
+			std::memcpy(dev.physicalKey, physicalKey, sizeof(physicalKey));
+			dev.knobAxisCount = knobAxisCount;
+			ioctl(fd, EVIOCGNAME(sizeof(dev.name) - 1), dev.name);
+			context.counters.AddSyscalls(1);
+			dev.fd = fd;
+			dev.vendorId = id.vendor;
+			dev.productId = id.product;
+
+			// Event timestamps on the steady_clock base, so report-to-read latency can be measured
+			int clockId = CLOCK_MONOTONIC;
+			dev.knobs.monotonicTimestamps = ioctl(fd, EVIOCSCLOCKID, &clockId) >= 0;
+			context.counters.AddSyscalls(1);
+
+			std::int32_t initialValues[ABS_CNT] = {};
+			for (int i = 0; i < ABS_CNT; ++i)
+			{
+				if (absBits[i / kBitsPerLong] & (1UL << (i % kBitsPerLong)))
+				{
+					struct input_absinfo absInfo{};
+					context.counters.AddSyscalls(1);
+					if (ioctl(fd, EVIOCGABS(i), &absInfo) >= 0)
+					{
+						dev.knobs.ranges[i].min = absInfo.minimum;
+						dev.knobs.ranges[i].max = absInfo.maximum;
+						dev.knobs.ranges[i].available = true;
+						initialValues[i] = absInfo.value;
+					}
+				}
+			}
+
+			SeedEvdevKnobAxes(dev.knobs, initialValues);
+
+			if (context.exclusiveGrab)
+			{
+				SetJoystickDeviceGrab(context, dev, true);
+			}
+
+			dev.opened = true;
+			dev.timing.Attach(context.deviceCounters);
+			context.joystickDevices.push_back(std::move(dev));
+			context.epollFdsChanged = true;
+#ifdef KSMAXIS_LINUX_IO_URING
+			AttachIoUring(context, context.joystickDevices.back());
+#endif
+			return true;
+		}
+
+		void ScanJoystickDevices(ContextImpl& context)
+		{
+			KSMAXIS_TRACE_SCOPE(trace, "ScanJoystickDevices");
+
+			// The directory fd is kept open and read with getdents64(), since opendir() allocates on every scan
+			if (context.inputDirFd < 0)
+			{
+				context.inputDirFd = open(kInputDirPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				context.counters.AddSyscalls(1);
+				if (context.inputDirFd < 0)
+				{
+					return;
+				}
+			}
+
+			context.counters.AddSyscalls(1);
+			if (lseek(context.inputDirFd, 0, SEEK_SET) < 0)
+			{
+				return;
+			}
+
+			// Retried on every scan: udev may start after the library, and /sys may be missing in containers
+			if (context.inputClassDirFd < 0)
+			{
+				context.inputClassDirFd = open(kInputClassDirPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				context.counters.AddSyscalls(1);
+			}
+			if (context.udevDataDirFd < 0)
+			{
+				context.udevDataDirFd = open(kUdevDataDirPath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				context.counters.AddSyscalls(1);
+			}
+
+			// A node was created or removed since the last scan, so a remembered number may now be another device
+			struct stat dirStat{};
+			context.counters.AddSyscalls(1);
+			if (fstat(context.inputDirFd, &dirStat) < 0 ||
+				dirStat.st_mtim.tv_sec != context.inputDirMtime.tv_sec || dirStat.st_mtim.tv_nsec != context.inputDirMtime.tv_nsec)
+			{
+				context.rejectedEventNodes.reset();
+				context.suppressedEventNodes.clear();
+				context.inputDirMtime = dirStat.st_mtim;
+			}
+
+			std::size_t openedCount = 0;
+			alignas(LinuxDirent64) char buffer[kDirentBufferSize];
+			long bytesRead;
+			while ((bytesRead = syscall(SYS_getdents64, context.inputDirFd, buffer, sizeof(buffer))) > 0)
+			{
+				context.counters.AddSyscalls(1);
+				for (long pos = 0; pos < bytesRead;)
+				{
+					const auto* entry = reinterpret_cast<const LinuxDirent64*>(buffer + pos);
+					const char* name = buffer + pos + offsetof(LinuxDirent64, name);
+					pos += entry->reclen;
+
+					if (OpenJoystickDevice(context, name))
+					{
+						++openedCount;
+					}
+				}
+			}
+
+			context.counters.AddSyscalls(1); // The getdents64() that ended the loop
+			KSMAXIS_TRACE_ARG(trace, "opened", openedCount);
+
+#ifdef KSMAXIS_LINUX_IO_URING
+			SubmitIoUring(context);
+#endif
+		}
+
+		bool MatchesX11MouseDevice(const XIDeviceInfo& info, const std::vector<std::string>& devices)
+		{
+			const std::string deviceId = std::to_string(info.deviceid);
+			for (const auto& device : devices)
+			{
+				if (device == deviceId || (info.name && device == info.name))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Selects XI_RawMotion on the master pointers, or only on the slave pointers named by SetX11MouseDevices()
+		// so that the server doesn't send motion of other pointers at all. Returns the number of selected slaves.
+		std::size_t SelectX11MouseEvents(ContextImpl& context)
+		{
+			KSMAXIS_TRACE_SCOPE(trace, "SelectX11MouseEvents");
+
+			const X11Api& x11 = *context.x11Mouse.api;
+			Display* display = context.x11Mouse.display;
+			const Window root = DefaultRootWindow(display);
+
+			// An all-zero mask removes a selection. Cleared first, since device ids are reused after a hotplug.
+			// XI_RawMotion is the highest event used here, so its mask length covers XI_HierarchyChanged too.
+			unsigned char emptyMask[XIMaskLen(XI_RawMotion)] = {};
+			XIEventMask clearMasks[kMaxX11MouseDevices + 2];
+			int clearCount = 0;
+			clearMasks[clearCount++] = { XIAllMasterDevices, static_cast<int>(sizeof(emptyMask)), emptyMask };
+			clearMasks[clearCount++] = { XIAllDevices, static_cast<int>(sizeof(emptyMask)), emptyMask };
+			for (std::size_t i = 0; i < context.x11Mouse.selectedDeviceCount; ++i)
+			{
+				clearMasks[clearCount++] = { context.x11Mouse.selectedDeviceIds[i], static_cast<int>(sizeof(emptyMask)), emptyMask };
+			}
+			x11.XISelectEvents(display, root, clearMasks, clearCount);
+			context.x11Mouse.selectedDeviceCount = 0;
+
+			unsigned char rawMotionMask[XIMaskLen(XI_RawMotion)] = {};
+			XISetMask(rawMotionMask, XI_RawMotion);
+
+			if (context.x11MouseDevices.empty())
+			{
+				XIEventMask eventMask = { XIAllMasterDevices, static_cast<int>(sizeof(rawMotionMask)), rawMotionMask };
+				x11.XISelectEvents(display, root, &eventMask, 1);
+				x11.XFlush(display);
+				return 0;
+			}
+
+			// Hierarchy changes (hotplug, xinput reattach) trigger a reselection from DrainX11Mouse()
+			unsigned char hierarchyMask[XIMaskLen(XI_RawMotion)] = {};
+			XISetMask(hierarchyMask, XI_HierarchyChanged);
+
+			XIEventMask eventMasks[kMaxX11MouseDevices + 1];
+			int maskCount = 0;
+			eventMasks[maskCount++] = { XIAllDevices, static_cast<int>(sizeof(hierarchyMask)), hierarchyMask };
+
+			int deviceCount = 0;
+			XIDeviceInfo* deviceInfos = x11.XIQueryDevice(display, XIAllDevices, &deviceCount);
+			for (int i = 0; i < deviceCount && context.x11Mouse.selectedDeviceCount < kMaxX11MouseDevices; ++i)
+			{
+				const XIDeviceInfo& info = deviceInfos[i];
+				if ((info.use == XISlavePointer || info.use == XIFloatingSlave) && MatchesX11MouseDevice(info, context.x11MouseDevices))
+				{
+					eventMasks[maskCount++] = { info.deviceid, static_cast<int>(sizeof(rawMotionMask)), rawMotionMask };
+					context.x11Mouse.selectedDeviceIds[context.x11Mouse.selectedDeviceCount++] = info.deviceid;
+				}
+			}
+			if (deviceInfos)
+			{
+				x11.XIFreeDeviceInfo(deviceInfos);
+			}
+
+			x11.XISelectEvents(display, root, eventMasks, maskCount);
+			x11.XFlush(display);
+
+			KSMAXIS_TRACE_ARG(trace, "devices", context.x11Mouse.selectedDeviceCount);
+			return context.x11Mouse.selectedDeviceCount;
+		}
+
+		template <typename T>
+		bool LoadX11Function(void* library, const char* name, T& function)
+		{
+			function = reinterpret_cast<T>(dlsym(library, name));
+			return function != nullptr;
+		}
+
+		X11Api LoadX11Api()
+		{
+			KSMAXIS_TRACE_SCOPE(trace, "LoadX11Api");
+
+			X11Api api;
+
+			// Never unloaded: Xlib keeps per-process state (e.g. extension hooks) that outlives any display
+			void* x11Library = dlopen("libX11.so.6", RTLD_NOW | RTLD_LOCAL);
+			void* xiLibrary = x11Library ? dlopen("libXi.so.6", RTLD_NOW | RTLD_LOCAL) : nullptr;
+			if (!xiLibrary)
+			{
+				const char* error = dlerror();
+				api.error = error ? error : "dlopen failed";
+				return api;
+			}
+
+			api.loaded =
+				LoadX11Function(x11Library, "XOpenDisplay", api.XOpenDisplay) &&
+				LoadX11Function(x11Library, "XCloseDisplay", api.XCloseDisplay) &&
+				LoadX11Function(x11Library, "XQueryExtension", api.XQueryExtension) &&
+				LoadX11Function(x11Library, "XFlush", api.XFlush) &&
+				LoadX11Function(x11Library, "XPending", api.XPending) &&
+				LoadX11Function(x11Library, "XEventsQueued", api.XEventsQueued) &&
+				LoadX11Function(x11Library, "XNextEvent", api.XNextEvent) &&
+				LoadX11Function(x11Library, "XGetEventData", api.XGetEventData) &&
+				LoadX11Function(x11Library, "XFreeEventData", api.XFreeEventData) &&
+				LoadX11Function(xiLibrary, "XIQueryVersion", api.XIQueryVersion) &&
+				LoadX11Function(xiLibrary, "XISelectEvents", api.XISelectEvents) &&
+				LoadX11Function(xiLibrary, "XIQueryDevice", api.XIQueryDevice) &&
+				LoadX11Function(xiLibrary, "XIFreeDeviceInfo", api.XIFreeDeviceInfo);
+			if (!api.loaded)
+			{
+				const char* error = dlerror();
+				api.error = error ? error : "dlsym failed";
+			}
+			return api;
+		}
+
+		// Loaded once per process; the table is immutable afterwards, so contexts on any thread can share it
+		const X11Api& GetX11Api()
+		{
+			static const X11Api api = LoadX11Api();
+			return api;
+		}
+
+		bool InitX11Mouse(ContextImpl& context, std::vector<std::string>* pWarningStrings)
+		{
+			KSMAXIS_TRACE_SCOPE(trace, "InitX11Mouse");
+
+			const X11Api& x11 = GetX11Api();
+			if (!x11.loaded)
+			{
+				if (pWarningStrings)
+				{
+					pWarningStrings->push_back("Failed to load libX11/libXi: " + x11.error);
+				}
+				return false;
+			}
+			context.x11Mouse.api = &x11;
+
+			context.x11Mouse.display = x11.XOpenDisplay(nullptr);
+			if (!context.x11Mouse.display)
+			{
+				if (pWarningStrings)
+				{
+					pWarningStrings->push_back("Failed to open X11 display");
+				}
+				return false;
+			}
+
+			int xiEvent, xiError;
+			if (!x11.XQueryExtension(context.x11Mouse.display, "XInputExtension", &context.x11Mouse.xiOpcode, &xiEvent, &xiError))
+			{
+				if (pWarningStrings)
+				{
+					pWarningStrings->push_back("XInput extension not available");
+				}
+				x11.XCloseDisplay(context.x11Mouse.display);
+				context.x11Mouse.display = nullptr;
+				return false;
+			}
+
+			int major = 2;
+			int minor = 2;
+			if (x11.XIQueryVersion(context.x11Mouse.display, &major, &minor) != Success)
+			{
+				if (pWarningStrings)
+				{
+					pWarningStrings->push_back("XInput2 version 2.2 not available");
+				}
+				x11.XCloseDisplay(context.x11Mouse.display);
+				context.x11Mouse.display = nullptr;
+				return false;
+			}
+
+			if (SelectX11MouseEvents(context) == 0 && !context.x11MouseDevices.empty() && pWarningStrings)
+			{
+				pWarningStrings->push_back("No XInput2 pointer matches SetX11MouseDevices(); waiting for one to be plugged in");
+			}
+
+			context.x11Mouse.initialized = true;
+			return true;
+		}
+
+		void TerminateX11Mouse(ContextImpl& context)
+		{
+			if (context.x11Mouse.display)
+			{
+				context.x11Mouse.api->XCloseDisplay(context.x11Mouse.display);
+				context.x11Mouse.display = nullptr;
+			}
+			context.x11Mouse.api = nullptr;
+			context.x11Mouse.initialized = false;
+			context.x11Mouse.xiOpcode = -1;
+			context.x11Mouse.selectedDeviceCount = 0;
+			context.x11Mouse.reselectPending = false;
+			context.x11Mouse.deltaX = 0.0;
+			context.x11Mouse.deltaY = 0.0;
+		}
+
+#ifdef KSMAXIS_LINUX_WAYLAND
+		// Maps a compositor timestamp onto GetMonotonicTimeNs(). Falls back to the dispatch time (read-time binning)
+		// when the compositor clock steps back and the timestamp would land more than kWaylandMaxEventAgeNs in the past.
+		std::int64_t RebaseWaylandTime(WaylandMouseContext& wayland, std::int64_t eventTimeNs)
+		{
+			const std::int64_t offsetNs = wayland.dispatchTimeNs - eventTimeNs;
+			if (!wayland.hasTimeOffset || offsetNs < wayland.timeOffsetNs || offsetNs - wayland.timeOffsetNs > kWaylandMaxEventAgeNs)
+			{
+				wayland.timeOffsetNs = offsetNs;
+				wayland.hasTimeOffset = true;
+			}
+			return eventTimeNs + wayland.timeOffsetNs;
+		}
+
+		void OnWaylandRelativeMotion(void* data, zwp_relative_pointer_v1*, std::uint32_t utimeHi, std::uint32_t utimeLo, wl_fixed_t, wl_fixed_t, wl_fixed_t dxUnaccel, wl_fixed_t dyUnaccel)
+		{
+			WaylandMouseContext& wayland = *static_cast<WaylandMouseContext*>(data);
+			const double deltaX = wl_fixed_to_double(dxUnaccel);
+			const double deltaY = wl_fixed_to_double(dyUnaccel);
+			wayland.deltaX += deltaX;
+			wayland.deltaY += deltaY;
+			const std::uint64_t utime = (static_cast<std::uint64_t>(utimeHi) << 32) | utimeLo;
+			wayland.lastMotionTimeNs = RebaseWaylandTime(wayland, static_cast<std::int64_t>(utime) * 1000);
+			wayland.resampler->Add(InputMode::kMouse, wayland.lastMotionTimeNs, deltaX, deltaY);
+		}
+
+		constexpr zwp_relative_pointer_v1_listener kWaylandRelativePointerListener = {
+			.relative_motion = OnWaylandRelativeMotion,
+		};
+
+		// Events of wl_pointer and zwp_locked_pointer_v1 are not needed; proxies without a listener drop them
+		void CreateWaylandPointer(WaylandMouseContext& wayland)
+		{
+			wayland.pointer = wl_seat_get_pointer(wayland.seat);
+
+			if (wayland.relativePointerManager)
+			{
+				wayland.relativePointer = zwp_relative_pointer_manager_v1_get_relative_pointer(wayland.relativePointerManager, wayland.pointer);
+				zwp_relative_pointer_v1_add_listener(wayland.relativePointer, &kWaylandRelativePointerListener, &wayland);
+			}
+
+			// Keeps the pointer from leaving the surface (and losing focus) while it is moved; re-engaged by the
+			// compositor whenever the surface regains pointer focus
+			if (wayland.lockPointer && wayland.pointerConstraints)
+			{
+				wayland.lockedPointer = zwp_pointer_constraints_v1_lock_pointer(wayland.pointerConstraints, wayland.surface, wayland.pointer, nullptr, ZWP_POINTER_CONSTRAINTS_V1_LIFETIME_PERSISTENT);
+			}
+		}
+
+		void DestroyWaylandPointer(WaylandMouseContext& wayland)
+		{
+			if (wayland.lockedPointer)
+			{
+				zwp_locked_pointer_v1_destroy(wayland.lockedPointer);
+				wayland.lockedPointer = nullptr;
+			}
+			if (wayland.relativePointer)
+			{
+				zwp_relative_pointer_v1_destroy(wayland.relativePointer);
+				wayland.relativePointer = nullptr;
+			}
+			if (wayland.pointer)
+			{
+				if (wl_pointer_get_version(wayland.pointer) >= WL_POINTER_RELEASE_SINCE_VERSION)
+				{
+					wl_pointer_release(wayland.pointer);
+				}
+				else
+				{
+					wl_pointer_destroy(wayland.pointer);
+				}
+				wayland.pointer = nullptr;
+			}
+		}
+
+		void OnWaylandSeatCapabilities(void* data, wl_seat*, std::uint32_t capabilities)
+		{
+			WaylandMouseContext& wayland = *static_cast<WaylandMouseContext*>(data);
+			const bool hasPointer = (capabilities & WL_SEAT_CAPABILITY_POINTER) != 0;
+			if (hasPointer && !wayland.pointer)
+			{
+				CreateWaylandPointer(wayland);
+			}
+			else if (!hasPointer && wayland.pointer)
+			{
+				DestroyWaylandPointer(wayland);
+			}
+		}
+
+		constexpr wl_seat_listener kWaylandSeatListener = {
+			.capabilities = OnWaylandSeatCapabilities,
+			.name = [](void*, wl_seat*, const char*) {},
+		};
+
+		void DestroyWaylandSeat(WaylandMouseContext& wayland)
+		{
+			DestroyWaylandPointer(wayland);
+			if (wayland.seat)
+			{
+				if (wl_seat_get_version(wayland.seat) >= WL_SEAT_RELEASE_SINCE_VERSION)
+				{
+					wl_seat_release(wayland.seat);
+				}
+				else
+				{
+					wl_seat_destroy(wayland.seat);
+				}
+				wayland.seat = nullptr;
+				wayland.seatName = 0;
+			}
+		}
+
+		// Uses the first seat; a seat announced later (e.g. after the first one is removed) is picked up by DrainWaylandMouse()
+		void OnWaylandGlobal(void* data, wl_registry* registry, std::uint32_t name, const char* interface, std::uint32_t version)
+		{
+			WaylandMouseContext& wayland = *static_cast<WaylandMouseContext*>(data);
+			if (std::strcmp(interface, wl_seat_interface.name) == 0 && !wayland.seat)
+			{
+				wayland.seat = static_cast<wl_seat*>(wl_registry_bind(registry, name, &wl_seat_interface, std::min(version, kWaylandSeatVersion)));
+				wayland.seatName = name;
+				wl_seat_add_listener(wayland.seat, &kWaylandSeatListener, &wayland);
+			}
+			else if (std::strcmp(interface, zwp_relative_pointer_manager_v1_interface.name) == 0 && !wayland.relativePointerManager)
+			{
+				wayland.relativePointerManager = static_cast<zwp_relative_pointer_manager_v1*>(wl_registry_bind(registry, name, &zwp_relative_pointer_manager_v1_interface, 1));
+			}
+			else if (std::strcmp(interface, zwp_pointer_constraints_v1_interface.name) == 0 && !wayland.pointerConstraints)
+			{
+				wayland.pointerConstraints = static_cast<zwp_pointer_constraints_v1*>(wl_registry_bind(registry, name, &zwp_pointer_constraints_v1_interface, 1));
+			}
+		}
+
+		void OnWaylandGlobalRemove(void* data, wl_registry*, std::uint32_t name)
+		{
+			WaylandMouseContext& wayland = *static_cast<WaylandMouseContext*>(data);
+			if (wayland.seat && name == wayland.seatName)
+			{
+				DestroyWaylandSeat(wayland);
+			}
+		}
+
+		constexpr wl_registry_listener kWaylandRegistryListener = {
+			.global = OnWaylandGlobal,
+			.global_remove = OnWaylandGlobalRemove,
+		};
+
+		void TerminateWaylandMouse(ContextImpl& context)
+		{
+			WaylandMouseContext& wayland = context.waylandMouse;
+
+			DestroyWaylandSeat(wayland);
+			if (wayland.relativePointerManager)
+			{
+				zwp_relative_pointer_manager_v1_destroy(wayland.relativePointerManager);
+			}
+			if (wayland.pointerConstraints)
+			{
+				zwp_pointer_constraints_v1_destroy(wayland.pointerConstraints);
+			}
+			if (wayland.registry)
+			{
+				wl_registry_destroy(wayland.registry);
+			}
+			if (wayland.displayWrapper)
+			{
+				wl_proxy_wrapper_destroy(wayland.displayWrapper);
+			}
+			if (wayland.queue)
+			{
+				wl_event_queue_destroy(wayland.queue);
+			}
+			if (wayland.display)
+			{
+				// Release the pointer lock now rather than on the application's next flush
+				wl_display_flush(wayland.display);
+				context.counters.AddSyscalls(1);
+			}
+
+			// The display fd stays open (it's the application's), so it has to leave the epoll set explicitly
+			wayland = WaylandMouseContext{};
+			context.epollFdsChanged = true;
+		}
+
+		bool InitWaylandMouse(ContextImpl& context, std::vector<std::string>* pWarningStrings)
+		{
+			KSMAXIS_TRACE_SCOPE(trace, "InitWaylandMouse");
+
+			WaylandMouseContext& wayland = context.waylandMouse;
+			wayland.display = static_cast<wl_display*>(context.waylandDisplay);
+			wayland.surface = static_cast<wl_surface*>(context.waylandSurface);
+			wayland.lockPointer = context.waylandLockPointer;
+			wayland.resampler = &context.tickResampler;
+
+			wayland.queue = wl_display_create_queue(wayland.display);
+			wayland.displayWrapper = wayland.queue ? static_cast<wl_display*>(wl_proxy_create_wrapper(wayland.display)) : nullptr;
+			if (!wayland.displayWrapper)
+			{
+				if (pWarningStrings)
+				{
+					pWarningStrings->push_back("Failed to create Wayland event queue");
+				}
+				TerminateWaylandMouse(context);
+				return false;
+			}
+			wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(wayland.displayWrapper), wayland.queue);
+
+			wayland.registry = wl_display_get_registry(wayland.displayWrapper);
+			wl_registry_add_listener(wayland.registry, &kWaylandRegistryListener, &wayland);
+
+			// The first roundtrip binds the globals, the second delivers the seat capabilities
+			if (wl_display_roundtrip_queue(wayland.display, wayland.queue) < 0 || wl_display_roundtrip_queue(wayland.display, wayland.queue) < 0)
+			{
+				if (pWarningStrings)
+				{
+					pWarningStrings->push_back("Wayland roundtrip failed");
+				}
+				TerminateWaylandMouse(context);
+				return false;
+			}
+
+			if (!wayland.relativePointerManager)
+			{
+				if (pWarningStrings)
+				{
+					pWarningStrings->push_back("Wayland compositor does not support zwp_relative_pointer_manager_v1");
+				}
+				TerminateWaylandMouse(context);
+				return false;
+			}
+
+			if (wayland.lockPointer && !wayland.pointerConstraints && pWarningStrings)
+			{
+				pWarningStrings->push_back("Wayland compositor does not support zwp_pointer_constraints_v1; the pointer is not locked");
+			}
+			if (!wayland.pointer && pWarningStrings)
+			{
+				pWarningStrings->push_back("No Wayland pointer; waiting for one to be plugged in");
+			}
+
+			wayland.initialized = true;
+			return true;
+		}
+
+		// Events the application's own reads have already taken off the socket don't show up on its fd
+		bool HasQueuedWaylandEvents(ContextImpl& context)
+		{
+			WaylandMouseContext& wayland = context.waylandMouse;
+			if (!wayland.initialized)
+			{
+				return false;
+			}
+
+			if (wl_display_prepare_read_queue(wayland.display, wayland.queue) != 0)
+			{
+				return true;
+			}
+			wl_display_cancel_read(wayland.display);
+			return false;
+		}
+#endif
+
+		// Without a Wayland surface, or if the Wayland backend is unavailable, falls back to X11 (XWayland on Wayland sessions)
+		bool InitMouse(ContextImpl& context, std::vector<std::string>* pWarningStrings)
+		{
+			if (context.waylandDisplay && context.waylandSurface)
+			{
+#ifdef KSMAXIS_LINUX_WAYLAND
+				if (InitWaylandMouse(context, pWarningStrings))
+				{
+					return true;
+				}
+#else
+				if (pWarningStrings)
+				{
+					pWarningStrings->push_back("Built without KSMAXIS_LINUX_WAYLAND; reading the mouse through X11");
+				}
+#endif
+			}
+
+			return InitX11Mouse(context, pWarningStrings);
+		}
+
+		void TerminateMouse(ContextImpl& context)
+		{
+			TerminateX11Mouse(context);
+#ifdef KSMAXIS_LINUX_WAYLAND
+			TerminateWaylandMouse(context);
+#endif
+		}
+
+		void AddRealtimeCaptureWarning(std::vector<std::string>* pWarningStrings, const std::string& what, int error, const char* hint)
+		{
+			if (pWarningStrings)
+			{
+				pWarningStrings->push_back(what + ": " + std::strerror(error) + hint);
+			}
+		}
+
+		// Applies SetRealtimeCapture() to the calling thread. Each setting that fails is reported and skipped.
+		void ApplyRealtimeCapture(ContextImpl& context, std::vector<std::string>* pWarningStrings)
+		{
+			KSMAXIS_TRACE_SCOPE(trace, "ApplyRealtimeCapture");
+
+			const RealtimeCaptureConfig& config = context.realtimeCapture;
+			if (config.fifoPriority > 0)
+			{
+				sched_param param{};
+				param.sched_priority = config.fifoPriority;
+				const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+				context.counters.AddSyscalls(1);
+				if (result != 0)
+				{
+					AddRealtimeCaptureWarning(pWarningStrings, "Failed to set SCHED_FIFO priority " + std::to_string(config.fifoPriority), result,
+						result == EPERM ? " (needs CAP_SYS_NICE or RLIMIT_RTPRIO)" : "");
+				}
+			}
+
+			if (!config.cpus.empty())
+			{
+				cpu_set_t cpuSet;
+				CPU_ZERO(&cpuSet);
+				for (const int cpu : config.cpus)
+				{
+					if (cpu >= 0 && cpu < CPU_SETSIZE)
+					{
+						CPU_SET(cpu, &cpuSet);
+					}
+				}
+				const int result = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+				context.counters.AddSyscalls(1);
+				if (result != 0)
+				{
+					AddRealtimeCaptureWarning(pWarningStrings, "Failed to pin the capture thread to the requested CPUs", result, "");
+				}
+			}
+
+			// The context holds the device, queue and tick storage inline, so locking it keeps the reads of Update() free
+			// of page faults. Only the context object itself is locked, not the heap memory it points to.
+			if (config.lockMemory && !context.memoryLocked)
+			{
+				// With larger pages, the pages of the context would be shared with other objects
+				const long pageSize = sysconf(_SC_PAGESIZE);
+				if (pageSize <= 0 || static_cast<std::size_t>(pageSize) > alignof(ContextImpl))
+				{
+					if (pWarningStrings)
+					{
+						pWarningStrings->push_back("Capture memory not locked: the page size " + std::to_string(pageSize) + " is larger than the context alignment");
+					}
+					return;
+				}
+
+				context.counters.AddSyscalls(1);
+				if (mlock(&context, sizeof(ContextImpl)) == 0)
+				{
+					context.memoryLocked = true;
+				}
+				else
+				{
+					const int error = errno;
+					AddRealtimeCaptureWarning(pWarningStrings, "Failed to lock capture memory", error,
+						error == ENOMEM || error == EPERM ? " (needs CAP_IPC_LOCK or a larger RLIMIT_MEMLOCK)" : "");
+				}
+			}
+			else if (!config.lockMemory && context.memoryLocked)
+			{
+				munlock(&context, sizeof(ContextImpl));
+				context.counters.AddSyscalls(1);
+				context.memoryLocked = false;
+			}
+		}
+
+		void InitDevices(ContextImpl& context, DeviceFlags deviceFlags, std::vector<std::string>* pWarningStrings)
+		{
+			context.epollFdsChanged = true;
+			context.lastScanTime = std::chrono::steady_clock::now();
+			context.capture.Reset(context.lastScanTime);
+
+			if ((deviceFlags & DeviceFlags::Joystick) != DeviceFlags::None)
+			{
+				// Only newly opened joysticks need the first-Update() resync; initializing the mouse alone must not
+				// drop the deltas of joysticks that are already running
+				context.firstUpdate = true;
+#ifdef KSMAXIS_LINUX_IO_URING
+				InitIoUring(context, pWarningStrings);
+#endif
+				ScanHidrawDevices(context);
+				ScanJoystickDevices(context);
+				context.initializedDevices = context.initializedDevices | DeviceFlags::Joystick;
+			}
+
+			if ((deviceFlags & DeviceFlags::Mouse) != DeviceFlags::None)
+			{
+				if (InitMouse(context, pWarningStrings))
+				{
+					context.initializedDevices = context.initializedDevices | DeviceFlags::Mouse;
+				}
+			}
+		}
+
+		void TerminateDevices(ContextImpl& context, DeviceFlags deviceFlags)
+		{
+			if ((deviceFlags & DeviceFlags::Joystick) != DeviceFlags::None)
+			{
+#ifdef KSMAXIS_LINUX_IO_URING
+				TerminateIoUring(context);
+#endif
+
+				for (auto& dev : context.joystickDevices)
+				{
+					if (dev.fd >= 0)
+					{
+						CloseFd(context.counters, dev.fd);
+						dev.fd = -1;
+					}
+				}
+				context.joystickDevices.clear();
+
+				TerminateHidrawDevices(context);
+
+				if (context.inputDirFd >= 0)
+				{
+					CloseFd(context.counters, context.inputDirFd);
+					context.inputDirFd = -1;
+				}
+				if (context.inputClassDirFd >= 0)
+				{
+					CloseFd(context.counters, context.inputClassDirFd);
+					context.inputClassDirFd = -1;
+				}
+				if (context.udevDataDirFd >= 0)
+				{
+					CloseFd(context.counters, context.udevDataDirFd);
+					context.udevDataDirFd = -1;
+				}
+				context.rejectedEventNodes.reset();
+				context.suppressedEventNodes.clear();
+				context.inputDirMtime = {};
+			}
+
+			if ((deviceFlags & DeviceFlags::Mouse) != DeviceFlags::None)
+			{
+				TerminateMouse(context);
+			}
+
+			context.initializedDevices = context.initializedDevices & ~deviceFlags;
+			context.epollFdsChanged = true;
+		}
+
+		std::size_t CollectPollFds(ContextImpl& context, pollfd* pollFds)
+		{
+			std::size_t count = 0;
+
+#ifdef KSMAXIS_LINUX_IO_URING
+			// The ring fd is readable while completions are waiting in the CQ ring
+			if (context.ioUring.initialized)
+			{
+				SubmitIoUring(context);
+				if (context.ioUring.failed)
+				{
+					FallBackFromIoUring(context);
+				}
+				else
+				{
+					pollFds[count++] = { context.ioUring.ringFd, POLLIN, 0 };
+				}
+			}
+#endif
+
+			for (const auto& dev : context.joystickDevices)
+			{
+				if (!dev.opened || dev.fd < 0)
+				{
+					continue;
+				}
+#ifdef KSMAXIS_LINUX_IO_URING
+				if (dev.uringSlot >= 0)
+				{
+					continue;
+				}
+#endif
+				pollFds[count++] = { dev.fd, POLLIN, 0 };
+			}
+
+			for (const auto& dev : context.hidrawDevices)
+			{
+				pollFds[count++] = { dev.fd, POLLIN, 0 };
+			}
+
+			if (context.x11Mouse.initialized && context.x11Mouse.display)
+			{
+				pollFds[count++] = { ConnectionNumber(context.x11Mouse.display), POLLIN, 0 };
+			}
+
+#ifdef KSMAXIS_LINUX_WAYLAND
+			if (context.waylandMouse.initialized)
+			{
+				// Pending requests (e.g. the pointer lock) must reach the compositor before blocking
+				wl_display_flush(context.waylandMouse.display);
+				context.counters.AddSyscalls(1);
+				pollFds[count++] = { wl_display_get_fd(context.waylandMouse.display), POLLIN, 0 };
+			}
+#endif
+
+			return count;
+		}
+
+		bool PollInput(ContextImpl& context, std::uint32_t timeoutMs)
+		{
+			// Events Xlib has already read off the connection don't show up on its fd
+			if (context.x11Mouse.initialized && context.x11Mouse.display && context.x11Mouse.api->XEventsQueued(context.x11Mouse.display, QueuedAlready) > 0)
+			{
+				return true;
+			}
+
+#ifdef KSMAXIS_LINUX_WAYLAND
+			if (HasQueuedWaylandEvents(context))
+			{
+				return true;
+			}
+#endif
+
+			pollfd pollFds[kMaxPollFds];
+			const nfds_t pollFdCount = static_cast<nfds_t>(CollectPollFds(context, pollFds));
+
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{ timeoutMs };
+			int ready = 0;
+
+			// Busy-poll while active so that input is picked up without a scheduler wakeup
+			const auto spinDuration = context.capture.GetSpinDuration();
+			if (pollFdCount > 0 && spinDuration.count() > 0)
+			{
+				const auto spinEnd = std::min(deadline, std::chrono::steady_clock::now() + spinDuration);
+				do
+				{
+					ready = poll(pollFds, pollFdCount, 0);
+					context.counters.AddSyscalls(1);
+				} while (ready == 0 && std::chrono::steady_clock::now() < spinEnd);
+			}
+
+			if (ready == 0)
+			{
+				const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+				if (remaining.count() > 0)
+				{
+					// With no fds this is a plain sleep, so callers still get their timeout
+					ready = poll(pollFds, pollFdCount, static_cast<int>(remaining.count()));
+					context.counters.AddSyscalls(1);
+				}
+			}
+
+			if (ready <= 0)
+			{
+				return false;
+			}
+
+			// A hung-up device would wake every wait until the next rescan, so make Update() rescan now
+			for (nfds_t i = 0; i < pollFdCount; ++i)
+			{
+				if (pollFds[i].revents & (POLLERR | POLLHUP | POLLNVAL))
+				{
+					context.lastScanTime = {};
+					break;
+				}
+			}
+
+			return true;
+		}
+
+		void DrainX11Mouse(ContextImpl& context, UpdateBudgetScope& budget)
+		{
+			if (!context.x11Mouse.initialized || !context.x11Mouse.display)
+			{
+				return;
+			}
+
+			KSMAXIS_TRACE_SCOPE(x11Trace, "DrainX11");
+
+			const X11Api& x11 = *context.x11Mouse.api;
+
+			std::size_t x11EventCount = 0;
+			std::int64_t readTimeNs = 0; // Raw events carry X server time, so they are binned by read time
+
+			while (!budget.IsExhausted() && x11.XPending(context.x11Mouse.display) > 0)
+			{
+				XEvent event;
+				x11.XNextEvent(context.x11Mouse.display, &event);
+				budget.AddEvents(1);
+				++x11EventCount;
+
+				XGenericEventCookie* cookie = &event.xcookie;
+				if (cookie->type == GenericEvent && cookie->extension == context.x11Mouse.xiOpcode && x11.XGetEventData(context.x11Mouse.display, cookie))
+				{
+					if (cookie->evtype == XI_HierarchyChanged)
+					{
+						context.x11Mouse.reselectPending = true;
+					}
+					else if (cookie->evtype == XI_RawMotion)
+					{
+						XIRawEvent* rawEvent = reinterpret_cast<XIRawEvent*>(cookie->data);
+						double* rawValues = rawEvent->raw_values;
+
+						double deltaX = 0.0;
+						double deltaY = 0.0;
+						if (XIMaskIsSet(rawEvent->valuators.mask, 0))
+						{
+							deltaX = *rawValues;
+							rawValues++;
+						}
+						if (XIMaskIsSet(rawEvent->valuators.mask, 1))
+						{
+							deltaY = *rawValues;
+						}
+						context.x11Mouse.deltaX += deltaX;
+						context.x11Mouse.deltaY += deltaY;
+
+						if (context.tickResampler.GetTickInterval() > 0)
+						{
+							if (readTimeNs == 0)
+							{
+								readTimeNs = GetMonotonicTimeNs();
+							}
+							context.tickResampler.Add(InputMode::kMouse, readTimeNs, deltaX, deltaY);
+						}
+					}
+					x11.XFreeEventData(context.x11Mouse.display, cookie);
+				}
+			}
+
+			if (context.x11Mouse.reselectPending)
+			{
+				context.x11Mouse.reselectPending = false;
+				SelectX11MouseEvents(context);
+			}
+
+			context.counters.AddX11Events(x11EventCount);
+
+			KSMAXIS_TRACE_ARG(x11Trace, "events", x11EventCount);
+		}
+
+#ifdef KSMAXIS_LINUX_WAYLAND
+		// Dispatches the private queue without blocking: events already queued, then whatever the socket holds
+		void DrainWaylandMouse(ContextImpl& context, UpdateBudgetScope& budget)
+		{
+			WaylandMouseContext& wayland = context.waylandMouse;
+			if (!wayland.initialized)
+			{
+				return;
+			}
+
+			KSMAXIS_TRACE_SCOPE(waylandTrace, "DrainWayland");
+
+			const std::int64_t prevMotionTimeNs = wayland.lastMotionTimeNs;
+			std::size_t waylandEventCount = 0;
+			bool failed = false;
+
+			wayland.dispatchTimeNs = GetMonotonicTimeNs();
+			while (wl_display_prepare_read_queue(wayland.display, wayland.queue) != 0)
+			{
+				const int count = wl_display_dispatch_queue_pending(wayland.display, wayland.queue);
+				if (count < 0)
+				{
+					failed = true;
+					break;
+				}
+				waylandEventCount += static_cast<std::size_t>(count);
+			}
+
+			if (!failed)
+			{
+				wl_display_flush(wayland.display);
+
+				pollfd pollFd = { wl_display_get_fd(wayland.display), POLLIN, 0 };
+				context.counters.AddSyscalls(2);
+				if (poll(&pollFd, 1, 0) > 0)
+				{
+					context.counters.AddSyscalls(1);
+					failed = wl_display_read_events(wayland.display) < 0;
+					wayland.dispatchTimeNs = GetMonotonicTimeNs();
+				}
+				else
+				{
+					wl_display_cancel_read(wayland.display);
+				}
+			}
+
+			if (!failed)
+			{
+				const int count = wl_display_dispatch_queue_pending(wayland.display, wayland.queue);
+				failed = count < 0;
+				waylandEventCount += static_cast<std::size_t>(std::max(count, 0));
+			}
+
+			budget.AddEvents(waylandEventCount);
+			context.counters.AddWaylandEvents(waylandEventCount);
+
+			KSMAXIS_TRACE_ARG(waylandTrace, "events", waylandEventCount);
+			if (wayland.lastMotionTimeNs != prevMotionTimeNs)
+			{
+				// Relative to the fastest delivery seen (see RebaseWaylandTime())
+				KSMAXIS_TRACE_ARG(waylandTrace, "latencyUs", (GetMonotonicTimeNs() - wayland.lastMotionTimeNs) / 1000);
+			}
+
+			// A lost connection or protocol error; the application gets the same error from its own dispatch
+			if (failed)
+			{
+				const double deltaX = wayland.deltaX;
+				const double deltaY = wayland.deltaY;
+				TerminateWaylandMouse(context);
+				wayland.deltaX = deltaX;
+				wayland.deltaY = deltaY;
+				context.initializedDevices = context.initializedDevices & ~DeviceFlags::Mouse;
+			}
+		}
+#endif
+
+		// Sources are numbered: the io_uring ring, then evdev devices, hidraw devices and the mouse connection (X11 or Wayland)
+		void DrainInputSource(ContextImpl& context, std::size_t source, std::size_t joystickCount, std::size_t hidrawCount, UpdateBudgetScope& budget)
+		{
+			if (source == 0)
+			{
+#ifdef KSMAXIS_LINUX_IO_URING
+				DrainIoUring(context, budget);
+#endif
+				return;
+			}
+			source -= 1;
+
+			// Devices may have been removed by an earlier source of this pass (e.g. an io_uring completion)
+			if (source < joystickCount)
+			{
+				if (source >= context.joystickDevices.size())
+				{
+					return;
+				}
+
+				JoystickDevice& dev = context.joystickDevices.begin()[source];
+#ifdef KSMAXIS_LINUX_IO_URING
+				if (!dev.opened || dev.fd < 0 || dev.uringSlot >= 0)
+#else
+				if (!dev.opened || dev.fd < 0)
+#endif
+				{
+					return;
+				}
+
+				// On disconnect, rescan on the next Update() so that a hung-up fd doesn't keep the poll fd readable
+				if (!DrainJoystickDevice(dev, context.activeModes, context.counters, budget, context.tickResampler))
+				{
+					context.lastScanTime = {};
+				}
+				return;
+			}
+			source -= joystickCount;
+
+			if (source < hidrawCount)
+			{
+				if (source >= context.hidrawDevices.size())
+				{
+					return;
+				}
+
+				HidrawDevice* it = context.hidrawDevices.begin() + source;
+				if (!DrainHidrawDevice(context, *it, budget))
+				{
+					CloseFd(context.counters, it->fd);
+					context.hidrawDevices.erase(it);
+				}
+				return;
+			}
+
+			DrainX11Mouse(context, budget);
+#ifdef KSMAXIS_LINUX_WAYLAND
+			DrainWaylandMouse(context, budget);
+#endif
+		}
+
+		// Drains every source once, starting after the one that exhausted the budget last time, so that
+		// a chattering device can't keep the others from being read across truncated Update() calls
+		void DrainInputSources(ContextImpl& context, UpdateBudgetScope& budget)
+		{
+			const std::size_t joystickCount = context.joystickDevices.size();
+			const std::size_t hidrawCount = context.hidrawDevices.size();
+			const std::size_t sourceCount = joystickCount + hidrawCount + 2;
+
+			for (std::size_t i = 0; i < sourceCount; ++i)
+			{
+				const std::size_t source = (context.drainStartSource + i) % sourceCount;
+				DrainInputSource(context, source, joystickCount, hidrawCount, budget);
+				if (budget.WasExhausted())
+				{
+					context.drainStartSource = (source + 1) % sourceCount;
+					return;
+				}
+			}
+		}
+
+		// Moves the deltas the sources accumulated while being drained into the given sums. Joystick deltas of the
+		// first Update() are dropped, since they are jumps from the initial positions.
+		void CollectDeltas(ContextImpl& context, AxisValues& deltaAnalogStick, AxisValues& deltaSlider, AxisValues& deltaMouse)
+		{
+			for (auto& dev : context.joystickDevices)
+			{
+				if (!context.firstUpdate)
+				{
+					deltaAnalogStick[0] += dev.knobs.deltaAxisX;
+					deltaAnalogStick[1] += dev.knobs.deltaAxisY;
+					deltaSlider[0] += dev.knobs.deltaSlider0;
+					deltaSlider[1] += dev.knobs.deltaSlider1;
+				}
+
+				dev.knobs.deltaAxisX = 0.0;
+				dev.knobs.deltaAxisY = 0.0;
+				dev.knobs.deltaSlider0 = 0.0;
+				dev.knobs.deltaSlider1 = 0.0;
+			}
+
+			for (auto& dev : context.hidrawDevices)
+			{
+				if (!context.firstUpdate)
+				{
+					deltaAnalogStick[0] += dev.deltas[kHidrawAxisX];
+					deltaAnalogStick[1] += dev.deltas[kHidrawAxisY];
+					deltaSlider[0] += dev.deltas[kHidrawSlider0];
+					deltaSlider[1] += dev.deltas[kHidrawSlider1];
+				}
+				std::fill(std::begin(dev.deltas), std::end(dev.deltas), 0.0);
+			}
+
+			deltaMouse[0] += context.x11Mouse.deltaX;
+			deltaMouse[1] += context.x11Mouse.deltaY;
+			context.x11Mouse.deltaX = 0.0;
+			context.x11Mouse.deltaY = 0.0;
+#ifdef KSMAXIS_LINUX_WAYLAND
+			deltaMouse[0] += context.waylandMouse.deltaX;
+			deltaMouse[1] += context.waylandMouse.deltaY;
+			context.waylandMouse.deltaX = 0.0;
+			context.waylandMouse.deltaY = 0.0;
+#endif
+		}
+
+		// Mirrors the fds of CollectPollFds() into the epoll set handed out by GetPollFd(). Only when they changed, since
+		// CollectPollFds() also submits io_uring SQEs and flushes Wayland, which an idle Update() must not pay for.
+		// Closed fds leave the set by themselves.
+		void SyncEpollFd(ContextImpl& context)
+		{
+			if (context.epollFd < 0 || !context.epollFdsChanged)
+			{
+				return;
+			}
+
+			pollfd pollFds[kMaxPollFds];
+			const std::size_t pollFdCount = CollectPollFds(context, pollFds);
+
+			// Closed fds have already left the set, so ENOENT/EBADF is expected here
+			for (std::size_t i = 0; i < context.epollRegisteredFdCount; ++i)
+			{
+				epoll_ctl(context.epollFd, EPOLL_CTL_DEL, context.epollRegisteredFds[i], nullptr);
+			}
+
+			for (std::size_t i = 0; i < pollFdCount; ++i)
+			{
+				epoll_event event{};
+				event.events = EPOLLIN;
+				event.data.fd = pollFds[i].fd;
+				epoll_ctl(context.epollFd, EPOLL_CTL_ADD, pollFds[i].fd, &event);
+				context.epollRegisteredFds[i] = pollFds[i].fd;
+			}
+			context.counters.AddSyscalls(context.epollRegisteredFdCount + pollFdCount);
+			context.epollRegisteredFdCount = pollFdCount;
+			context.epollFdsChanged = false;
+		}
+	}
+
+	Context::Context()
+		: m_pImpl(std::make_unique<ContextImpl>())
+	{
+	}
+
+	Context::~Context()
+	{
+		Terminate();
+
+		ContextImpl& context = *m_pImpl;
+		if (context.epollFd >= 0)
+		{
+			CloseFd(context.counters, context.epollFd);
+		}
+		if (context.memoryLocked)
+		{
+			munlock(&context, sizeof(ContextImpl));
+			context.counters.AddSyscalls(1);
+		}
+	}
+
+	bool Context::Init(DeviceFlags deviceFlags, std::string* pErrorString, std::vector<std::string>* pWarningStrings)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.requestedDevices = context.requestedDevices | deviceFlags;
+
+		if (context.realtimeCapturePending)
+		{
+			ApplyRealtimeCapture(context, pWarningStrings);
+			context.realtimeCapturePending = false;
+		}
+
+		// Skip already initialized devices, and defer those that no active InputMode needs
+		deviceFlags = deviceFlags & ~context.initializedDevices & context.activeModes.GetRequiredDeviceFlags();
+		if (deviceFlags == DeviceFlags::None)
+		{
+			return true;
+		}
+
+		KSMAXIS_TRACE_SCOPE(trace, "Init");
+
+		InitDevices(context, deviceFlags, pWarningStrings);
+		SyncEpollFd(context);
+		return true;
+	}
+
+	void Context::SetActiveInputModes(const std::vector<InputMode>& modes, std::vector<std::string>* pWarningStrings)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.activeModes = InputModeSet::FromList(modes);
+
+		const DeviceFlags requiredDevices = context.activeModes.GetRequiredDeviceFlags();
+		TerminateDevices(context, context.initializedDevices & ~requiredDevices);
+
+		const DeviceFlags deferredDevices = context.requestedDevices & requiredDevices & ~context.initializedDevices;
+		if (deferredDevices != DeviceFlags::None)
+		{
+			KSMAXIS_TRACE_SCOPE(trace, "Init");
+			InitDevices(context, deferredDevices, pWarningStrings);
+		}
+		SyncEpollFd(context);
+
+		// Don't keep reporting deltas of modes that were just deactivated
+		context.deltaAnalogStick = { 0.0, 0.0 };
+		context.deltaSlider = { 0.0, 0.0 };
+		context.deltaMouse = { 0.0, 0.0 };
+		context.lateDeltas = {};
+		context.lateShaper.Reset();
+	}
+
+	bool Context::IsInputModeActive(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.activeModes.Contains(mode);
+	}
+
+	bool Context::IsInitialized() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.initializedDevices != DeviceFlags::None;
+	}
+
+	bool Context::IsInitialized(DeviceFlags deviceFlags) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return (context.initializedDevices & deviceFlags) == deviceFlags;
+	}
+
+	void Context::Terminate()
+	{
+		ContextImpl& context = *m_pImpl;
+		TerminateDevices(context, DeviceFlags::All);
+		context.requestedDevices = DeviceFlags::None;
+		SyncEpollFd(context);
+	}
+
+	void Context::Update()
+	{
+		ContextImpl& context = *m_pImpl;
+		KSMAXIS_TRACE_SCOPE(trace, "Update");
+		detail::CaptureCpuScope cpuScope{ context.capture, context.counters };
+		detail::UpdateDurationScope durationScope{ context.counters };
+
+		context.deltaAnalogStick = { 0.0, 0.0 };
+		context.deltaSlider = { 0.0, 0.0 };
+		context.deltaMouse = { 0.0, 0.0 };
+		context.lateDeltas = {};
+		context.lateShaper.Reset();
+		context.lastUpdateTruncated = false;
+		context.tickResampler.ClearTicks();
+		context.changeTracker.ClearChangedModes();
+
+		if (context.initializedDevices == DeviceFlags::None)
+		{
+			return;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - context.lastScanTime);
+		if ((context.initializedDevices & DeviceFlags::Joystick) != DeviceFlags::None && elapsed >= context.capture.GetRescanInterval())
+		{
+			KSMAXIS_TRACE_SCOPE(rescanTrace, "Rescan");
+			RemoveDisconnectedJoystickDevices(context);
+			ScanHidrawDevices(context);
+			ScanJoystickDevices(context);
+			context.lastScanTime = now;
+			context.counters.AddRescan();
+		}
+
+		// The first Update() discards its deltas, so there is nothing to bin
+		if (!context.firstUpdate)
+		{
+			context.tickResampler.BeginFrame(GetMonotonicTimeNs());
+		}
+
+		UpdateBudgetScope budget{ context.updateBudget };
+		DrainInputSources(context, budget);
+		context.lastUpdateTruncated = budget.WasExhausted();
+		if (context.lastUpdateTruncated)
+		{
+			context.counters.AddTruncatedUpdate();
+		}
+
+		CollectDeltas(context, context.deltaAnalogStick, context.deltaSlider, context.deltaMouse);
+
+		// Shaped before anything records the deltas, so that every consumer sees the same values
+		const std::array<AxisValues, kInputModeCount> rawDeltas = { context.deltaAnalogStick, context.deltaSlider, context.deltaMouse };
+		context.responseCurves.Apply(InputMode::kAnalogStick, context.deltaAnalogStick);
+		context.responseCurves.Apply(InputMode::kSlider, context.deltaSlider);
+		context.responseCurves.Apply(InputMode::kMouse, context.deltaMouse);
+		context.lateShaper.OnUpdate(rawDeltas, { context.deltaAnalogStick, context.deltaSlider, context.deltaMouse });
+
+		context.axisTotals.Add(InputMode::kAnalogStick, context.deltaAnalogStick);
+		context.axisTotals.Add(InputMode::kSlider, context.deltaSlider);
+		context.axisTotals.Add(InputMode::kMouse, context.deltaMouse);
+		context.tickResampler.EndFrame(rawDeltas, { context.deltaAnalogStick, context.deltaSlider, context.deltaMouse });
+		context.changeTracker.OnUpdate({ context.deltaAnalogStick, context.deltaSlider, context.deltaMouse });
+
+		const bool hadInput = context.changeTracker.GetChangedModes() != 0;
+		context.capture.OnUpdate(hadInput, now);
+
+		context.firstUpdate = false;
+
+		SyncEpollFd(context);
+		durationScope.Stop();
+
+		// Last, since a resumed coroutine may read the deltas or await again
+		if (hadInput)
+		{
+			context.inputWaiters.ResumeAll();
+		}
+	}
+
+	void Context::LatchLateInput()
+	{
+		ContextImpl& context = *m_pImpl;
+		KSMAXIS_TRACE_SCOPE(trace, "LatchLateInput");
+		detail::CaptureCpuScope cpuScope{ context.capture, context.counters };
+
+		// The first Update() resyncs the devices, so there is nothing to latch before it
+		if (context.initializedDevices == DeviceFlags::None || context.firstUpdate)
+		{
+			return;
+		}
+
+		UpdateBudgetScope budget{ context.updateBudget };
+		DrainInputSources(context, budget);
+
+		std::array<AxisValues, kInputModeCount> deltas{};
+		CollectDeltas(context, deltas[0], deltas[1], deltas[2]);
+		context.lateShaper.Shape(context.responseCurves, deltas);
+		for (std::size_t i = 0; i < kInputModeCount; ++i)
+		{
+			const InputMode mode = static_cast<InputMode>(i);
+			context.axisTotals.Add(mode, deltas[i]);
+			context.lateDeltas[i][0] += deltas[i][0];
+			context.lateDeltas[i][1] += deltas[i][1];
+		}
+		context.changeTracker.OnLateInput(deltas);
+	}
+
+	AxisValues Context::GetLateAxisDeltas(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.lateDeltas[static_cast<std::size_t>(mode)];
+	}
+
+	bool Context::WaitForInput(std::uint32_t timeoutMs)
+	{
+		ContextImpl& context = *m_pImpl;
+		KSMAXIS_TRACE_SCOPE(trace, "WaitForInput");
+		detail::CaptureCpuScope cpuScope{ context.capture, context.counters };
+
+		const bool ready = PollInput(context, timeoutMs);
+		context.capture.AddWakeup();
+
+		KSMAXIS_TRACE_ARG(trace, "ready", ready);
+		return ready;
+	}
+
+	void Context::SetUpdateBudget(const UpdateBudget& budget)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.updateBudget = budget;
+	}
+
+	UpdateBudget Context::GetUpdateBudget() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.updateBudget;
+	}
+
+	bool Context::WasUpdateTruncated() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.lastUpdateTruncated;
+	}
+
+	UpdateStats Context::GetUpdateStats() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.counters.GetStats();
+	}
+
+	void Context::ResetUpdateStats()
+	{
+		ContextImpl& context = *m_pImpl;
+		context.counters.Reset();
+	}
+
+	std::size_t Context::GetDeviceCounters(std::span<DeviceCounters> counters) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.deviceCounters.Read(counters);
+	}
+
+	int Context::GetPollFd()
+	{
+		ContextImpl& context = *m_pImpl;
+		if (context.epollFd < 0)
+		{
+			context.epollFd = epoll_create1(EPOLL_CLOEXEC);
+			context.counters.AddSyscalls(1);
+			if (context.epollFd < 0)
+			{
+				return -1;
+			}
+			context.epollFdsChanged = true;
+		}
+
+		SyncEpollFd(context);
+		return context.epollFd;
+	}
+
+	void Context::AddInputWaiter(std::coroutine_handle<> handle)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.inputWaiters.Add(handle);
+	}
+
+	void Context::SetCapturePolicy(const CapturePolicy& policy)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.capture.SetPolicy(policy);
+	}
+
+	CapturePolicy Context::GetCapturePolicy() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.capture.GetPolicy();
+	}
+
+	CaptureState Context::GetCaptureState() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.capture.GetState();
+	}
+
+	CaptureStats Context::GetCaptureStats() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.capture.GetStats();
+	}
+
+	void Context::ResetCaptureStats()
+	{
+		ContextImpl& context = *m_pImpl;
+		context.capture.ResetStats();
+	}
+
+	std::vector<DeviceInfo> Context::GetDevices() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		std::vector<DeviceInfo> devices;
+
+		const auto toAxisInfo = [](const AxisRange& range)
+		{
+			return DeviceAxisInfo{ range.available, range.min, range.max };
+		};
+
+		for (const auto& dev : context.joystickDevices)
+		{
+			if (!dev.opened)
+			{
+				continue;
+			}
+
+			DeviceInfo& info = devices.emplace_back();
+			info.name = dev.name;
+			info.path = dev.path;
+#ifdef KSMAXIS_LINUX_IO_URING
+			info.backend = dev.uringSlot >= 0 ? "evdev (io_uring)" : "evdev";
+#else
+			info.backend = "evdev";
+#endif
+			info.vendorId = dev.vendorId;
+			info.productId = dev.productId;
+			info.id = dev.timing.GetDeviceId();
+			info.grabbed = dev.grabbed;
+			info.axes[0] = toAxisInfo(dev.knobs.ranges[ABS_X]);
+			info.axes[1] = toAxisInfo(dev.knobs.ranges[ABS_Y]);
+			info.axes[2] = toAxisInfo(dev.knobs.ranges[ABS_THROTTLE].available ? dev.knobs.ranges[ABS_THROTTLE] : dev.knobs.ranges[ABS_MISC]);
+			info.axes[3] = toAxisInfo(dev.knobs.ranges[ABS_RUDDER]);
+			info.stats = dev.timing.Summarize();
+			for (const auto& node : context.suppressedEventNodes)
+			{
+				if (std::strcmp(node.keptPath, dev.path) == 0)
+				{
+					info.suppressedPaths.emplace_back(node.path);
+				}
+			}
+		}
+
+		for (const auto& dev : context.hidrawDevices)
+		{
+			DeviceInfo& info = devices.emplace_back();
+			info.name = dev.name;
+			info.path = dev.path;
+			info.id = dev.timing.GetDeviceId();
+			info.backend = "hidraw";
+			info.vendorId = dev.vendorId;
+			info.productId = dev.productId;
+			for (std::size_t i = 0; i < dev.fieldCount; ++i)
+			{
+				const HidrawField& field = dev.fields[i];
+				info.axes[field.axis] = DeviceAxisInfo{ true, field.logicalMin, field.logicalMax };
+			}
+			info.stats = dev.timing.Summarize();
+		}
+
+		return devices;
+	}
+
+	void Context::ResetDeviceStats()
+	{
+		ContextImpl& context = *m_pImpl;
+		for (auto& dev : context.joystickDevices)
+		{
+			dev.timing.Reset();
+		}
+		for (auto& dev : context.hidrawDevices)
+		{
+			dev.timing.Reset();
+		}
+	}
+
+	void Context::SetHidrawAxisMappings(const std::vector<HidrawAxisMapping>& mappings)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.hidrawAxisMappings = mappings;
+	}
+
+	void Context::SetX11MouseDevices(const std::vector<std::string>& devices)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.x11MouseDevices = devices;
+
+		if (context.x11Mouse.initialized && context.x11Mouse.display)
+		{
+			SelectX11MouseEvents(context);
+		}
+	}
+
+	void Context::SetRealtimeCapture(const RealtimeCaptureConfig& config)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.realtimeCapture = config;
+		context.realtimeCapturePending = true;
+	}
+
+	bool Context::SetExclusiveGrab(bool enabled)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.exclusiveGrab = enabled;
+
+		bool allGrabbed = true;
+		for (auto& dev : context.joystickDevices)
+		{
+			if (dev.opened)
+			{
+				SetJoystickDeviceGrab(context, dev, enabled);
+				allGrabbed = allGrabbed && dev.grabbed;
+			}
+		}
+		return !enabled || allGrabbed;
+	}
+
+	void Context::SetWaylandSurface(void* pDisplay, void* pSurface, bool lockPointer)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.waylandDisplay = pDisplay;
+		context.waylandSurface = pSurface;
+		context.waylandLockPointer = lockPointer;
+	}
+
+	AxisValues Context::GetAxisDeltas(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		if (mode == InputMode::kAnalogStick)
+		{
+			return context.deltaAnalogStick;
+		}
+		else if (mode == InputMode::kMouse)
+		{
+			return context.deltaMouse;
+		}
+		else
+		{
+			return context.deltaSlider;
+		}
+	}
+
+	AxisValues Context::GetAxisTotals(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.axisTotals.Get(mode);
+	}
+
+	std::uint32_t Context::GetChangedModes() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.changeTracker.GetChangedModes();
+	}
+
+	std::uint64_t Context::GetChangeGeneration() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.changeTracker.GetGeneration();
+	}
+
+	std::uint64_t Context::GetChangeGeneration(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.changeTracker.GetGeneration(mode);
+	}
+
+	bool Context::SetResponseCurve(InputMode mode, const ResponseCurve& curve, std::string* pErrorString)
+	{
+		ContextImpl& context = *m_pImpl;
+		ResponseCurveTable table;
+		if (!CompileResponseCurve(curve, table, pErrorString))
+		{
+			return false;
+		}
+		context.responseCurves.Set(mode, table);
+		return true;
+	}
+
+	void Context::SetResponseCurve(InputMode mode, const ResponseCurveTable& table)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.responseCurves.Set(mode, table);
+	}
+
+	void Context::ClearResponseCurve(InputMode mode)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.responseCurves.Clear(mode);
+	}
+
+	void Context::SetTickInterval(std::uint32_t tickUs)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.tickResampler.SetTickInterval(tickUs);
+	}
+
+	std::span<const AxisValues> Context::GetTickDeltas(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.tickResampler.GetTicks(mode);
+	}
+
+	std::int64_t Context::GetFirstTickTimeNs() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.tickResampler.GetFirstTickTimeNs();
 	}
 }
 
@@ -1,16 +1,40 @@
-#ifdef __APPLE__
+﻿#ifdef __APPLE__
 
 #include <IOKit/hid/IOHIDManager.h>
 #include <IOKit/hid/IOHIDKeys.h>
 #include <CoreFoundation/CoreFoundation.h>
+#include <mach/mach_time.h>
 
 #include "ksmaxis/ksmaxis.hpp"
+#include "ksmaxis_trace.hpp"
+#include "ksmaxis_capture.hpp"
+#include "ksmaxis_device_stats.hpp"
+#include "ksmaxis_axis.hpp"
+#include "ksmaxis_modes.hpp"
+#include "ksmaxis_update_stats.hpp"
+#include "ksmaxis_waiters.hpp"
+#include "ksmaxis_resample.hpp"
+#include "ksmaxis_curve.hpp"
 
 #include <vector>
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 
 namespace ksmaxis
 {
+	using detail::ApplyAxisValue;
+	using detail::AxisTotals;
+	using detail::ChangeTracker;
+	using detail::DeviceCounterTable;
+	using detail::DeviceTimingAccumulator;
+	using detail::GetMonotonicTimeNs;
+	using detail::InputModeSet;
+	using detail::LateDeltaShaper;
+	using detail::ResponseCurveSet;
+	using detail::TickResampler;
+	using detail::UpdateCounters;
+
 	namespace
 	{
 		constexpr std::uint32_t kUsagePageGenericDesktop = 0x01;
@@ -19,7 +43,6 @@ namespace ksmaxis
 		constexpr std::uint32_t kUsageSlider = 0x36;
 		constexpr std::uint32_t kUsageDial = 0x37;
 
-		constexpr double kWrapThreshold = 0.5;
 		constexpr double kDeviceMatchingWaitSec = 0.1;
 		constexpr double kRunLoopIntervalSec = 0.01;
 
@@ -31,10 +54,14 @@ namespace ksmaxis
 			double axisY = 0.0;
 			double slider0 = 0.0;
 			double slider1 = 0.0;
-			double prevAxisX = 0.0;
-			double prevAxisY = 0.0;
-			double prevSlider0 = 0.0;
-			double prevSlider1 = 0.0;
+			// Wrap-corrected deltas accumulated per value callback since the last Update()
+			double deltaAxisX = 0.0;
+			double deltaAxisY = 0.0;
+			double deltaSlider0 = 0.0;
+			double deltaSlider1 = 0.0;
+			std::uint64_t lastTimestamp = 0;
+			std::int64_t lastReportTimeNs = 0; // lastTimestamp rebased onto GetMonotonicTimeNs()
+			DeviceTimingAccumulator timing;
 		};
 
 		struct MouseDevice
@@ -44,17 +71,43 @@ namespace ksmaxis
 			double deltaX = 0.0;
 			double deltaY = 0.0;
 		};
+	}
+
+	namespace detail
+	{
+		// State owned by a Context (no process-global mutable state)
+		struct ContextImpl
+		{
+			IOHIDManagerRef joystickHidManager = nullptr;
+			IOHIDManagerRef mouseHidManager = nullptr;
+			// Declared before the device list, whose devices free their counter slots when destroyed
+			DeviceCounterTable deviceCounters;
+			std::vector<JoystickDevice> joystickDevices;
+			std::vector<MouseDevice> mouseDevices;
+			DeviceFlags initializedDevices = DeviceFlags::None;
+			DeviceFlags requestedDevices = DeviceFlags::None; // Passed to Init(), including devices deferred by activeModes
+			InputModeSet activeModes = InputModeSet::All();
+			bool firstUpdate = true;
+			AxisValues deltaAnalogStick = { 0.0, 0.0 };
+			AxisValues deltaSlider = { 0.0, 0.0 };
+			AxisValues deltaMouse = { 0.0, 0.0 };
+			AxisTotals axisTotals;
+			ChangeTracker changeTracker;
+			ResponseCurveSet responseCurves;
+			TickResampler tickResampler;
+			std::array<AxisValues, kInputModeCount> lateDeltas{}; // See LatchLateInput()
+			LateDeltaShaper lateShaper;
+			CaptureTracker capture;
+			UpdateCounters counters;
+			UpdateBudget updateBudget; // Stored only: each Update() services a single run loop source already
+			detail::InputWaiterList inputWaiters;
+		};
+	}
 
-		IOHIDManagerRef s_joystickHidManager = nullptr;
-		IOHIDManagerRef s_mouseHidManager = nullptr;
-		std::vector<JoystickDevice> s_joystickDevices;
-		std::vector<MouseDevice> s_mouseDevices;
-		DeviceFlags s_initializedDevices = DeviceFlags::None;
-		bool s_firstUpdate = true;
-		AxisValues s_deltaAnalogStick = { 0.0, 0.0 };
-		AxisValues s_deltaSlider = { 0.0, 0.0 };
-		AxisValues s_deltaMouse = { 0.0, 0.0 };
+	using detail::ContextImpl;
 
+	namespace
+	{
 		const char* GetIOReturnErrorString(IOReturn result)
 		{
 			switch (result)
@@ -76,34 +129,50 @@ namespace ksmaxis
 			return static_cast<double>(value) / 255.0;
 		}
 
-		double CalculateDelta(double current, double prev)
+		std::int64_t MachTimeToNs(std::uint64_t machTime)
 		{
-			double delta = current - prev;
-			if (delta > kWrapThreshold) delta -= 1.0;
-			else if (delta < -kWrapThreshold) delta += 1.0;
-			return delta;
+			static const mach_timebase_info_data_t timebase = []
+			{
+				mach_timebase_info_data_t info{};
+				mach_timebase_info(&info);
+				return info;
+			}();
+			return static_cast<std::int64_t>(static_cast<double>(machTime) * timebase.numer / timebase.denom);
+		}
+
+		std::int32_t GetDeviceIntProperty(IOHIDDeviceRef deviceRef, CFStringRef key)
+		{
+			std::int32_t value = 0;
+			CFTypeRef ref = IOHIDDeviceGetProperty(deviceRef, key);
+			if (ref && CFGetTypeID(ref) == CFNumberGetTypeID())
+			{
+				CFNumberGetValue(static_cast<CFNumberRef>(ref), kCFNumberSInt32Type, &value);
+			}
+			return value;
 		}
 
-		JoystickDevice* FindJoystickDevice(IOHIDDeviceRef deviceRef)
+		JoystickDevice* FindJoystickDevice(ContextImpl& context, IOHIDDeviceRef deviceRef)
 		{
-			for (auto& dev : s_joystickDevices)
+			for (auto& dev : context.joystickDevices)
 			{
 				if (dev.device == deviceRef) return &dev;
 			}
 			return nullptr;
 		}
 
-		MouseDevice* FindMouseDevice(IOHIDDeviceRef deviceRef)
+		MouseDevice* FindMouseDevice(ContextImpl& context, IOHIDDeviceRef deviceRef)
 		{
-			for (auto& dev : s_mouseDevices)
+			for (auto& dev : context.mouseDevices)
 			{
 				if (dev.device == deviceRef) return &dev;
 			}
 			return nullptr;
 		}
 
-		void JoystickInputValueCallback(void* context, IOReturn result, void* sender, IOHIDValueRef valueRef)
+		void JoystickInputValueCallback(void* pContext, IOReturn result, void* sender, IOHIDValueRef valueRef)
 		{
+			ContextImpl& context = *static_cast<ContextImpl*>(pContext);
+
 			if (!valueRef) return;
 
 			IOHIDElementRef element = IOHIDValueGetElement(valueRef);
@@ -112,9 +181,23 @@ namespace ksmaxis
 			IOHIDDeviceRef deviceRef = IOHIDElementGetDevice(element);
 			if (!deviceRef) return;
 
-			JoystickDevice* dev = FindJoystickDevice(deviceRef);
+			JoystickDevice* dev = FindJoystickDevice(context, deviceRef);
 			if (!dev) return;
 
+			dev->timing.AddEvents(1);
+			context.counters.AddEvents(1);
+
+			// Values of one report share a timestamp. Timestamps are mach_absolute_time(), which doesn't share its base
+			// with steady_clock, so they are rebased onto the read time by their age.
+			const std::uint64_t timestamp = IOHIDValueGetTimeStamp(valueRef);
+			if (timestamp != dev->lastTimestamp)
+			{
+				dev->lastTimestamp = timestamp;
+				const std::int64_t readTimeNs = GetMonotonicTimeNs();
+				dev->lastReportTimeNs = readTimeNs - (MachTimeToNs(mach_absolute_time()) - MachTimeToNs(timestamp));
+				dev->timing.AddReport(dev->lastReportTimeNs, readTimeNs);
+			}
+
 			std::uint32_t usagePage = IOHIDElementGetUsagePage(element);
 			std::uint32_t usage = IOHIDElementGetUsage(element);
 
@@ -123,32 +206,50 @@ namespace ksmaxis
 			std::int64_t intValue = IOHIDValueGetIntegerValue(valueRef);
 			double normalized = Normalize(intValue);
 
+			// Per-value wrap correction so fast spins between Update() calls don't alias, binned into the ticks by the
+			// report timestamp (values dispatched outside Update(), e.g. by WaitForInput(), land in the last tick)
+			const bool stickActive = context.activeModes.Contains(InputMode::kAnalogStick);
+			const bool sliderActive = context.activeModes.Contains(InputMode::kSlider);
+			double delta = 0.0;
 			if (usage == kUsageX)
 			{
-				dev->axisX = normalized;
+				ApplyAxisValue(normalized, dev->axisX, delta, stickActive);
+				dev->deltaAxisX += delta;
+				context.tickResampler.Add(InputMode::kAnalogStick, dev->lastReportTimeNs, delta, 0.0);
 			}
 			else if (usage == kUsageY)
 			{
-				dev->axisY = normalized;
+				ApplyAxisValue(normalized, dev->axisY, delta, stickActive);
+				dev->deltaAxisY += delta;
+				context.tickResampler.Add(InputMode::kAnalogStick, dev->lastReportTimeNs, 0.0, delta);
 			}
 			else if (usage == kUsageSlider)
 			{
-				dev->slider0 = normalized;
+				ApplyAxisValue(normalized, dev->slider0, delta, sliderActive);
+				dev->deltaSlider0 += delta;
+				context.tickResampler.Add(InputMode::kSlider, dev->lastReportTimeNs, delta, 0.0);
 			}
 			else if (usage == kUsageDial)
 			{
-				dev->slider1 = normalized;
+				ApplyAxisValue(normalized, dev->slider1, delta, sliderActive);
+				dev->deltaSlider1 += delta;
+				context.tickResampler.Add(InputMode::kSlider, dev->lastReportTimeNs, 0.0, delta);
 			}
 		}
 
-		void JoystickDeviceMatchedCallback(void* context, IOReturn result, void* sender, IOHIDDeviceRef deviceRef)
+		void JoystickDeviceMatchedCallback(void* pContext, IOReturn result, void* sender, IOHIDDeviceRef deviceRef)
 		{
+			ContextImpl& context = *static_cast<ContextImpl*>(pContext);
+
 			if (!deviceRef) return;
-			if (FindJoystickDevice(deviceRef)) return;
+			if (FindJoystickDevice(context, deviceRef)) return;
 
 			JoystickDevice dev{};
 			dev.device = deviceRef;
 
+			// Devices beyond the counter table are ignored, like those beyond the fixed device lists on Linux
+			if (!dev.timing.Attach(context.deviceCounters)) return;
+
 			CFStringRef productRef = (CFStringRef)IOHIDDeviceGetProperty(deviceRef, CFSTR(kIOHIDProductKey));
 			if (productRef)
 			{
@@ -159,27 +260,30 @@ namespace ksmaxis
 				snprintf(dev.productName, sizeof(dev.productName), "Unknown Device");
 			}
 
-			s_joystickDevices.push_back(dev);
-
-			IOHIDDeviceRegisterInputValueCallback(deviceRef, JoystickInputValueCallback, nullptr);
-			IOHIDDeviceScheduleWithRunLoop(deviceRef, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
+			// Values arrive through the input value callback of the manager, which is scheduled for all its devices.
+			// Registering it on the device as well would deliver every value twice.
+			context.joystickDevices.push_back(std::move(dev));
 		}
 
-		void JoystickDeviceRemovedCallback(void* context, IOReturn result, void* sender, IOHIDDeviceRef deviceRef)
+		void JoystickDeviceRemovedCallback(void* pContext, IOReturn result, void* sender, IOHIDDeviceRef deviceRef)
 		{
-			for (auto it = s_joystickDevices.begin(); it != s_joystickDevices.end(); ++it)
+			ContextImpl& context = *static_cast<ContextImpl*>(pContext);
+
+			for (auto it = context.joystickDevices.begin(); it != context.joystickDevices.end(); ++it)
 			{
 				if (it->device == deviceRef)
 				{
-					s_joystickDevices.erase(it);
+					context.joystickDevices.erase(it);
 					break;
 				}
 			}
 		}
 
 		// Mouse callbacks
-		void MouseInputValueCallback(void* context, IOReturn result, void* sender, IOHIDValueRef valueRef)
+		void MouseInputValueCallback(void* pContext, IOReturn result, void* sender, IOHIDValueRef valueRef)
 		{
+			ContextImpl& context = *static_cast<ContextImpl*>(pContext);
+
 			if (!valueRef) return;
 
 			IOHIDElementRef element = IOHIDValueGetElement(valueRef);
@@ -188,7 +292,7 @@ namespace ksmaxis
 			IOHIDDeviceRef deviceRef = IOHIDElementGetDevice(element);
 			if (!deviceRef) return;
 
-			MouseDevice* dev = FindMouseDevice(deviceRef);
+			MouseDevice* dev = FindMouseDevice(context, deviceRef);
 			if (!dev) return;
 
 			std::uint32_t usagePage = IOHIDElementGetUsagePage(element);
@@ -208,10 +312,12 @@ namespace ksmaxis
 			}
 		}
 
-		void MouseDeviceMatchedCallback(void* context, IOReturn result, void* sender, IOHIDDeviceRef deviceRef)
+		void MouseDeviceMatchedCallback(void* pContext, IOReturn result, void* sender, IOHIDDeviceRef deviceRef)
 		{
+			ContextImpl& context = *static_cast<ContextImpl*>(pContext);
+
 			if (!deviceRef) return;
-			if (FindMouseDevice(deviceRef)) return;
+			if (FindMouseDevice(context, deviceRef)) return;
 
 			MouseDevice dev{};
 			dev.device = deviceRef;
@@ -226,239 +332,639 @@ namespace ksmaxis
 				snprintf(dev.productName, sizeof(dev.productName), "Unknown Mouse");
 			}
 
-			s_mouseDevices.push_back(dev);
-
-			IOHIDDeviceRegisterInputValueCallback(deviceRef, MouseInputValueCallback, nullptr);
-			IOHIDDeviceScheduleWithRunLoop(deviceRef, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
+			// Values arrive through the input value callback of the manager, which is scheduled for all its devices.
+			// Registering it on the device as well would deliver every value twice.
+			context.mouseDevices.push_back(dev);
 		}
 
-		void MouseDeviceRemovedCallback(void* context, IOReturn result, void* sender, IOHIDDeviceRef deviceRef)
+		void MouseDeviceRemovedCallback(void* pContext, IOReturn result, void* sender, IOHIDDeviceRef deviceRef)
 		{
-			for (auto it = s_mouseDevices.begin(); it != s_mouseDevices.end(); ++it)
+			ContextImpl& context = *static_cast<ContextImpl*>(pContext);
+
+			for (auto it = context.mouseDevices.begin(); it != context.mouseDevices.end(); ++it)
 			{
 				if (it->device == deviceRef)
 				{
-					s_mouseDevices.erase(it);
+					context.mouseDevices.erase(it);
 					break;
 				}
 			}
 		}
-	}
 
-	bool Init(DeviceFlags deviceFlags, std::string* pErrorString, std::vector<std::string>* pWarningStrings)
-	{
-		// Skip already initialized devices
-		deviceFlags = deviceFlags & ~s_initializedDevices;
-		if (deviceFlags == DeviceFlags::None)
+		void InitDevices(ContextImpl& context, DeviceFlags deviceFlags, std::vector<std::string>* pWarningStrings)
 		{
-			return true;
-		}
+			context.capture.Reset(std::chrono::steady_clock::now());
 
-		s_firstUpdate = true;
-
-		// Initialize joystick HID manager (failure is non-fatal)
-		if ((deviceFlags & DeviceFlags::Joystick) != DeviceFlags::None)
-		{
-			s_joystickHidManager = IOHIDManagerCreate(kCFAllocatorDefault, kIOHIDOptionsTypeNone);
-			if (!s_joystickHidManager)
+			// Initialize joystick HID manager (failure is non-fatal)
+			if ((deviceFlags & DeviceFlags::Joystick) != DeviceFlags::None)
 			{
-				if (pWarningStrings)
+				// Only newly opened joysticks need the first-Update() resync; initializing the mouse alone must not
+				// drop the deltas of joysticks that are already running
+				context.firstUpdate = true;
+				context.joystickHidManager = IOHIDManagerCreate(kCFAllocatorDefault, kIOHIDOptionsTypeNone);
+				if (!context.joystickHidManager)
 				{
-					pWarningStrings->push_back("Joystick IOHIDManagerCreate failed");
+					if (pWarningStrings)
+					{
+						pWarningStrings->push_back("Joystick IOHIDManagerCreate failed");
+					}
+				}
+				else
+				{
+					std::int32_t usagePage = kHIDPage_GenericDesktop;
+					std::int32_t usages[] = {
+						kHIDUsage_GD_Joystick,
+						kHIDUsage_GD_GamePad,
+						kHIDUsage_GD_MultiAxisController
+					};
+
+					CFMutableArrayRef matchArray = CFArrayCreateMutable(kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks);
+					for (std::int32_t usage : usages)
+					{
+						CFMutableDictionaryRef matchDict = CFDictionaryCreateMutable(
+							kCFAllocatorDefault, 0,
+							&kCFTypeDictionaryKeyCallBacks,
+							&kCFTypeDictionaryValueCallBacks);
+						CFNumberRef pageRef = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &usagePage);
+						CFNumberRef usageRef = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &usage);
+						CFDictionarySetValue(matchDict, CFSTR(kIOHIDDeviceUsagePageKey), pageRef);
+						CFDictionarySetValue(matchDict, CFSTR(kIOHIDDeviceUsageKey), usageRef);
+						CFRelease(pageRef);
+						CFRelease(usageRef);
+						CFArrayAppendValue(matchArray, matchDict);
+						CFRelease(matchDict);
+					}
+
+					IOHIDManagerSetDeviceMatchingMultiple(context.joystickHidManager, matchArray);
+					CFRelease(matchArray);
+
+					IOHIDManagerRegisterDeviceMatchingCallback(context.joystickHidManager, JoystickDeviceMatchedCallback, &context);
+					IOHIDManagerRegisterDeviceRemovalCallback(context.joystickHidManager, JoystickDeviceRemovedCallback, &context);
+					IOHIDManagerRegisterInputValueCallback(context.joystickHidManager, JoystickInputValueCallback, &context);
+
+					IOHIDManagerScheduleWithRunLoop(context.joystickHidManager, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
+
+					IOReturn openResult = IOHIDManagerOpen(context.joystickHidManager, kIOHIDOptionsTypeNone);
+					if (openResult != kIOReturnSuccess && openResult != kIOReturnExclusiveAccess)
+					{
+						if (pWarningStrings)
+						{
+							pWarningStrings->push_back(std::string{ "Joystick IOHIDManagerOpen failed: " } + GetIOReturnErrorString(openResult));
+						}
+						CFRelease(context.joystickHidManager);
+						context.joystickHidManager = nullptr;
+					}
+					else
+					{
+						for (double t = 0.0; t < kDeviceMatchingWaitSec; t += kRunLoopIntervalSec)
+						{
+							CFRunLoopRunInMode(kCFRunLoopDefaultMode, kRunLoopIntervalSec, true);
+						}
+						context.initializedDevices = context.initializedDevices | DeviceFlags::Joystick;
+					}
 				}
 			}
-			else
+
+			// Initialize mouse HID manager
+			if ((deviceFlags & DeviceFlags::Mouse) != DeviceFlags::None)
 			{
-				std::int32_t usagePage = kHIDPage_GenericDesktop;
-				std::int32_t usages[] = {
-					kHIDUsage_GD_Joystick,
-					kHIDUsage_GD_GamePad,
-					kHIDUsage_GD_MultiAxisController
-				};
-
-				CFMutableArrayRef matchArray = CFArrayCreateMutable(kCFAllocatorDefault, 0, &kCFTypeArrayCallBacks);
-				for (std::int32_t usage : usages)
+				context.mouseHidManager = IOHIDManagerCreate(kCFAllocatorDefault, kIOHIDOptionsTypeNone);
+				if (context.mouseHidManager)
 				{
-					CFMutableDictionaryRef matchDict = CFDictionaryCreateMutable(
+					std::int32_t mouseUsagePage = kHIDPage_GenericDesktop;
+					std::int32_t mouseUsage = kHIDUsage_GD_Mouse;
+
+					CFMutableDictionaryRef mouseMatchDict = CFDictionaryCreateMutable(
 						kCFAllocatorDefault, 0,
 						&kCFTypeDictionaryKeyCallBacks,
 						&kCFTypeDictionaryValueCallBacks);
-					CFNumberRef pageRef = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &usagePage);
-					CFNumberRef usageRef = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &usage);
-					CFDictionarySetValue(matchDict, CFSTR(kIOHIDDeviceUsagePageKey), pageRef);
-					CFDictionarySetValue(matchDict, CFSTR(kIOHIDDeviceUsageKey), usageRef);
-					CFRelease(pageRef);
-					CFRelease(usageRef);
-					CFArrayAppendValue(matchArray, matchDict);
-					CFRelease(matchDict);
-				}
+					CFNumberRef mousePageRef = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &mouseUsagePage);
+					CFNumberRef mouseUsageRef = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &mouseUsage);
+					CFDictionarySetValue(mouseMatchDict, CFSTR(kIOHIDDeviceUsagePageKey), mousePageRef);
+					CFDictionarySetValue(mouseMatchDict, CFSTR(kIOHIDDeviceUsageKey), mouseUsageRef);
+					CFRelease(mousePageRef);
+					CFRelease(mouseUsageRef);
 
-				IOHIDManagerSetDeviceMatchingMultiple(s_joystickHidManager, matchArray);
-				CFRelease(matchArray);
+					IOHIDManagerSetDeviceMatching(context.mouseHidManager, mouseMatchDict);
+					CFRelease(mouseMatchDict);
 
-				IOHIDManagerRegisterDeviceMatchingCallback(s_joystickHidManager, JoystickDeviceMatchedCallback, nullptr);
-				IOHIDManagerRegisterDeviceRemovalCallback(s_joystickHidManager, JoystickDeviceRemovedCallback, nullptr);
-				IOHIDManagerRegisterInputValueCallback(s_joystickHidManager, JoystickInputValueCallback, nullptr);
+					IOHIDManagerRegisterDeviceMatchingCallback(context.mouseHidManager, MouseDeviceMatchedCallback, &context);
+					IOHIDManagerRegisterDeviceRemovalCallback(context.mouseHidManager, MouseDeviceRemovedCallback, &context);
+					IOHIDManagerRegisterInputValueCallback(context.mouseHidManager, MouseInputValueCallback, &context);
 
-				IOHIDManagerScheduleWithRunLoop(s_joystickHidManager, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
+					IOHIDManagerScheduleWithRunLoop(context.mouseHidManager, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
 
-				IOReturn openResult = IOHIDManagerOpen(s_joystickHidManager, kIOHIDOptionsTypeNone);
-				if (openResult != kIOReturnSuccess && openResult != kIOReturnExclusiveAccess)
-				{
-					if (pWarningStrings)
+					IOReturn mouseOpenResult = IOHIDManagerOpen(context.mouseHidManager, kIOHIDOptionsTypeNone);
+					if (mouseOpenResult != kIOReturnSuccess && mouseOpenResult != kIOReturnExclusiveAccess)
 					{
-						pWarningStrings->push_back(std::string{ "Joystick IOHIDManagerOpen failed: " } + GetIOReturnErrorString(openResult));
+						if (pWarningStrings)
+						{
+							pWarningStrings->push_back(std::string{ "Mouse IOHIDManagerOpen failed: " } + GetIOReturnErrorString(mouseOpenResult));
+						}
+						CFRelease(context.mouseHidManager);
+						context.mouseHidManager = nullptr;
 					}
-					CFRelease(s_joystickHidManager);
-					s_joystickHidManager = nullptr;
-				}
-				else
-				{
-					for (double t = 0.0; t < kDeviceMatchingWaitSec; t += kRunLoopIntervalSec)
+					else
 					{
-						CFRunLoopRunInMode(kCFRunLoopDefaultMode, kRunLoopIntervalSec, true);
+						for (double t = 0.0; t < kDeviceMatchingWaitSec; t += kRunLoopIntervalSec)
+						{
+							CFRunLoopRunInMode(kCFRunLoopDefaultMode, kRunLoopIntervalSec, true);
+						}
+						context.initializedDevices = context.initializedDevices | DeviceFlags::Mouse;
 					}
-					s_initializedDevices = s_initializedDevices | DeviceFlags::Joystick;
 				}
 			}
 		}
 
-		// Initialize mouse HID manager
-		if ((deviceFlags & DeviceFlags::Mouse) != DeviceFlags::None)
+		void TerminateDevices(ContextImpl& context, DeviceFlags deviceFlags)
 		{
-			s_mouseHidManager = IOHIDManagerCreate(kCFAllocatorDefault, kIOHIDOptionsTypeNone);
-			if (s_mouseHidManager)
+			if ((deviceFlags & DeviceFlags::Joystick) != DeviceFlags::None)
 			{
-				std::int32_t mouseUsagePage = kHIDPage_GenericDesktop;
-				std::int32_t mouseUsage = kHIDUsage_GD_Mouse;
-
-				CFMutableDictionaryRef mouseMatchDict = CFDictionaryCreateMutable(
-					kCFAllocatorDefault, 0,
-					&kCFTypeDictionaryKeyCallBacks,
-					&kCFTypeDictionaryValueCallBacks);
-				CFNumberRef mousePageRef = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &mouseUsagePage);
-				CFNumberRef mouseUsageRef = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &mouseUsage);
-				CFDictionarySetValue(mouseMatchDict, CFSTR(kIOHIDDeviceUsagePageKey), mousePageRef);
-				CFDictionarySetValue(mouseMatchDict, CFSTR(kIOHIDDeviceUsageKey), mouseUsageRef);
-				CFRelease(mousePageRef);
-				CFRelease(mouseUsageRef);
-
-				IOHIDManagerSetDeviceMatching(s_mouseHidManager, mouseMatchDict);
-				CFRelease(mouseMatchDict);
-
-				IOHIDManagerRegisterDeviceMatchingCallback(s_mouseHidManager, MouseDeviceMatchedCallback, nullptr);
-				IOHIDManagerRegisterDeviceRemovalCallback(s_mouseHidManager, MouseDeviceRemovedCallback, nullptr);
-				IOHIDManagerRegisterInputValueCallback(s_mouseHidManager, MouseInputValueCallback, nullptr);
-
-				IOHIDManagerScheduleWithRunLoop(s_mouseHidManager, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
-
-				IOReturn mouseOpenResult = IOHIDManagerOpen(s_mouseHidManager, kIOHIDOptionsTypeNone);
-				if (mouseOpenResult != kIOReturnSuccess && mouseOpenResult != kIOReturnExclusiveAccess)
+				if (context.joystickHidManager)
 				{
-					if (pWarningStrings)
-					{
-						pWarningStrings->push_back(std::string{ "Mouse IOHIDManagerOpen failed: " } + GetIOReturnErrorString(mouseOpenResult));
-					}
-					CFRelease(s_mouseHidManager);
-					s_mouseHidManager = nullptr;
+					IOHIDManagerUnscheduleFromRunLoop(context.joystickHidManager, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
+					IOHIDManagerClose(context.joystickHidManager, kIOHIDOptionsTypeNone);
+					CFRelease(context.joystickHidManager);
+					context.joystickHidManager = nullptr;
 				}
-				else
+				context.joystickDevices.clear();
+			}
+
+			if ((deviceFlags & DeviceFlags::Mouse) != DeviceFlags::None)
+			{
+				if (context.mouseHidManager)
 				{
-					for (double t = 0.0; t < kDeviceMatchingWaitSec; t += kRunLoopIntervalSec)
+					IOHIDManagerUnscheduleFromRunLoop(context.mouseHidManager, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
+					IOHIDManagerClose(context.mouseHidManager, kIOHIDOptionsTypeNone);
+					CFRelease(context.mouseHidManager);
+					context.mouseHidManager = nullptr;
+				}
+				context.mouseDevices.clear();
+			}
+
+			context.initializedDevices = context.initializedDevices & ~deviceFlags;
+		}
+
+		// Value callbacks run (and accumulate deltas) while the run loop is serviced here
+		bool RunLoopUntilInput(ContextImpl& context, std::uint32_t timeoutMs)
+		{
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{ timeoutMs };
+
+			// Busy-poll while active so that input is picked up without a scheduler wakeup
+			const auto spinDuration = context.capture.GetSpinDuration();
+			if (spinDuration.count() > 0)
+			{
+				const auto spinEnd = std::min(deadline, std::chrono::steady_clock::now() + spinDuration);
+				do
+				{
+					context.counters.AddSyscalls(1);
+					if (CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0, true) == kCFRunLoopRunHandledSource)
 					{
-						CFRunLoopRunInMode(kCFRunLoopDefaultMode, kRunLoopIntervalSec, true);
+						return true;
 					}
-					s_initializedDevices = s_initializedDevices | DeviceFlags::Mouse;
+				} while (std::chrono::steady_clock::now() < spinEnd);
+			}
+
+			const auto remaining = std::chrono::duration<double>(deadline - std::chrono::steady_clock::now());
+			if (remaining.count() <= 0.0)
+			{
+				return false;
+			}
+
+			context.counters.AddSyscalls(1);
+			return CFRunLoopRunInMode(kCFRunLoopDefaultMode, remaining.count(), true) == kCFRunLoopRunHandledSource;
+		}
+
+		// Moves the deltas the value callbacks accumulated into the given sums. Joystick deltas of the first
+		// Update() are dropped, since they are jumps from the initial positions.
+		void CollectDeltas(ContextImpl& context, AxisValues& deltaAnalogStick, AxisValues& deltaSlider, AxisValues& deltaMouse)
+		{
+			for (auto& dev : context.joystickDevices)
+			{
+				if (!context.firstUpdate)
+				{
+					deltaAnalogStick[0] += dev.deltaAxisX;
+					deltaAnalogStick[1] += dev.deltaAxisY;
+					deltaSlider[0] += dev.deltaSlider0;
+					deltaSlider[1] += dev.deltaSlider1;
 				}
+
+				dev.deltaAxisX = 0.0;
+				dev.deltaAxisY = 0.0;
+				dev.deltaSlider0 = 0.0;
+				dev.deltaSlider1 = 0.0;
 			}
+
+			for (auto& dev : context.mouseDevices)
+			{
+				deltaMouse[0] += dev.deltaX;
+				deltaMouse[1] += dev.deltaY;
+				dev.deltaX = 0.0;
+				dev.deltaY = 0.0;
+			}
+		}
+	}
+
+	Context::Context()
+		: m_pImpl(std::make_unique<ContextImpl>())
+	{
+	}
+
+	Context::~Context()
+	{
+		Terminate();
+	}
+
+	bool Context::Init(DeviceFlags deviceFlags, std::string* pErrorString, std::vector<std::string>* pWarningStrings)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.requestedDevices = context.requestedDevices | deviceFlags;
+
+		// Skip already initialized devices, and defer those that no active InputMode needs
+		deviceFlags = deviceFlags & ~context.initializedDevices & context.activeModes.GetRequiredDeviceFlags();
+		if (deviceFlags == DeviceFlags::None)
+		{
+			return true;
 		}
 
+		KSMAXIS_TRACE_SCOPE(trace, "Init");
+
+		InitDevices(context, deviceFlags, pWarningStrings);
 		return true;
 	}
 
-	bool IsInitialized()
+	void Context::SetActiveInputModes(const std::vector<InputMode>& modes, std::vector<std::string>* pWarningStrings)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.activeModes = InputModeSet::FromList(modes);
+
+		const DeviceFlags requiredDevices = context.activeModes.GetRequiredDeviceFlags();
+		TerminateDevices(context, context.initializedDevices & ~requiredDevices);
+
+		const DeviceFlags deferredDevices = context.requestedDevices & requiredDevices & ~context.initializedDevices;
+		if (deferredDevices != DeviceFlags::None)
+		{
+			KSMAXIS_TRACE_SCOPE(trace, "Init");
+			InitDevices(context, deferredDevices, pWarningStrings);
+		}
+
+		// Don't keep reporting deltas of modes that were just deactivated
+		context.deltaAnalogStick = { 0.0, 0.0 };
+		context.deltaSlider = { 0.0, 0.0 };
+		context.deltaMouse = { 0.0, 0.0 };
+		context.lateDeltas = {};
+		context.lateShaper.Reset();
+	}
+
+	bool Context::IsInputModeActive(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.activeModes.Contains(mode);
+	}
+
+	bool Context::IsInitialized() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.initializedDevices != DeviceFlags::None;
+	}
+
+	bool Context::IsInitialized(DeviceFlags deviceFlags) const
 	{
-		return s_initializedDevices != DeviceFlags::None;
+		const ContextImpl& context = *m_pImpl;
+		return (context.initializedDevices & deviceFlags) == deviceFlags;
 	}
 
-	bool IsInitialized(DeviceFlags deviceFlags)
+	void Context::Terminate()
 	{
-		return (s_initializedDevices & deviceFlags) == deviceFlags;
+		ContextImpl& context = *m_pImpl;
+		TerminateDevices(context, DeviceFlags::All);
+		context.requestedDevices = DeviceFlags::None;
 	}
 
-	void Terminate()
+	void Context::Update()
 	{
-		if (s_joystickHidManager)
+		ContextImpl& context = *m_pImpl;
+		KSMAXIS_TRACE_SCOPE(trace, "Update");
+		detail::CaptureCpuScope cpuScope{ context.capture, context.counters };
+		detail::UpdateDurationScope durationScope{ context.counters };
+
+		context.deltaAnalogStick = { 0.0, 0.0 };
+		context.deltaSlider = { 0.0, 0.0 };
+		context.deltaMouse = { 0.0, 0.0 };
+		context.lateDeltas = {};
+		context.lateShaper.Reset();
+		context.tickResampler.ClearTicks();
+		context.changeTracker.ClearChangedModes();
+
+		if (context.initializedDevices == DeviceFlags::None) return;
+
+		// Joystick values are binned by report timestamp; raw mouse deltas land in the last tick
+		if (!context.firstUpdate)
 		{
-			IOHIDManagerUnscheduleFromRunLoop(s_joystickHidManager, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
-			IOHIDManagerClose(s_joystickHidManager, kIOHIDOptionsTypeNone);
-			CFRelease(s_joystickHidManager);
-			s_joystickHidManager = nullptr;
+			context.tickResampler.BeginFrame(GetMonotonicTimeNs());
 		}
-		if (s_mouseHidManager)
+
 		{
-			IOHIDManagerUnscheduleFromRunLoop(s_mouseHidManager, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
-			IOHIDManagerClose(s_mouseHidManager, kIOHIDOptionsTypeNone);
-			CFRelease(s_mouseHidManager);
-			s_mouseHidManager = nullptr;
+			KSMAXIS_TRACE_SCOPE(runLoopTrace, "RunLoop");
+			CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0, true);
+			context.counters.AddSyscalls(1);
+		}
+
+		CollectDeltas(context, context.deltaAnalogStick, context.deltaSlider, context.deltaMouse);
+
+		// Shaped before anything records the deltas, so that every consumer sees the same values
+		const std::array<AxisValues, kInputModeCount> rawDeltas = { context.deltaAnalogStick, context.deltaSlider, context.deltaMouse };
+		context.responseCurves.Apply(InputMode::kAnalogStick, context.deltaAnalogStick);
+		context.responseCurves.Apply(InputMode::kSlider, context.deltaSlider);
+		context.responseCurves.Apply(InputMode::kMouse, context.deltaMouse);
+		context.lateShaper.OnUpdate(rawDeltas, { context.deltaAnalogStick, context.deltaSlider, context.deltaMouse });
+
+		context.axisTotals.Add(InputMode::kAnalogStick, context.deltaAnalogStick);
+		context.axisTotals.Add(InputMode::kSlider, context.deltaSlider);
+		context.axisTotals.Add(InputMode::kMouse, context.deltaMouse);
+		context.tickResampler.EndFrame(rawDeltas, { context.deltaAnalogStick, context.deltaSlider, context.deltaMouse });
+		context.changeTracker.OnUpdate({ context.deltaAnalogStick, context.deltaSlider, context.deltaMouse });
+
+		const bool hadInput = context.changeTracker.GetChangedModes() != 0;
+		context.capture.OnUpdate(hadInput, std::chrono::steady_clock::now());
+
+		context.firstUpdate = false;
+		durationScope.Stop();
+
+		// Last, since a resumed coroutine may read the deltas or await again
+		if (hadInput)
+		{
+			context.inputWaiters.ResumeAll();
 		}
-		s_joystickDevices.clear();
-		s_mouseDevices.clear();
-		s_initializedDevices = DeviceFlags::None;
 	}
 
-	void Update()
+	std::vector<DeviceInfo> Context::GetDevices() const
 	{
-		s_deltaAnalogStick = { 0.0, 0.0 };
-		s_deltaSlider = { 0.0, 0.0 };
-		s_deltaMouse = { 0.0, 0.0 };
+		const ContextImpl& context = *m_pImpl;
+		std::vector<DeviceInfo> devices;
 
-		if (s_initializedDevices == DeviceFlags::None) return;
+		for (const auto& dev : context.joystickDevices)
+		{
+			DeviceInfo& info = devices.emplace_back();
+			info.name = dev.productName;
 
-		CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0, true);
+			char locationId[16];
+			snprintf(locationId, sizeof(locationId), "0x%08x", static_cast<unsigned>(GetDeviceIntProperty(dev.device, CFSTR(kIOHIDLocationIDKey))));
+			info.path = locationId;
 
-		for (auto& dev : s_joystickDevices)
-		{
-			if (!s_firstUpdate)
+			info.id = dev.timing.GetDeviceId();
+			info.backend = "IOKit";
+			info.vendorId = static_cast<std::uint16_t>(GetDeviceIntProperty(dev.device, CFSTR(kIOHIDVendorIDKey)));
+			info.productId = static_cast<std::uint16_t>(GetDeviceIntProperty(dev.device, CFSTR(kIOHIDProductIDKey)));
+
+			CFArrayRef elements = IOHIDDeviceCopyMatchingElements(dev.device, nullptr, kIOHIDOptionsTypeNone);
+			if (elements)
 			{
-				s_deltaAnalogStick[0] += CalculateDelta(dev.axisX, dev.prevAxisX);
-				s_deltaAnalogStick[1] += CalculateDelta(dev.axisY, dev.prevAxisY);
-				s_deltaSlider[0] += CalculateDelta(dev.slider0, dev.prevSlider0);
-				s_deltaSlider[1] += CalculateDelta(dev.slider1, dev.prevSlider1);
+				for (CFIndex i = 0; i < CFArrayGetCount(elements); ++i)
+				{
+					auto element = static_cast<IOHIDElementRef>(const_cast<void*>(CFArrayGetValueAtIndex(elements, i)));
+					if (IOHIDElementGetUsagePage(element) != kUsagePageGenericDesktop)
+					{
+						continue;
+					}
+
+					std::size_t axisIndex;
+					switch (IOHIDElementGetUsage(element))
+					{
+					case kUsageX: axisIndex = 0; break;
+					case kUsageY: axisIndex = 1; break;
+					case kUsageSlider: axisIndex = 2; break;
+					case kUsageDial: axisIndex = 3; break;
+					default: continue;
+					}
+
+					info.axes[axisIndex] = DeviceAxisInfo{
+						true,
+						static_cast<std::int32_t>(IOHIDElementGetLogicalMin(element)),
+						static_cast<std::int32_t>(IOHIDElementGetLogicalMax(element)),
+					};
+				}
+				CFRelease(elements);
 			}
 
-			dev.prevAxisX = dev.axisX;
-			dev.prevAxisY = dev.axisY;
-			dev.prevSlider0 = dev.slider0;
-			dev.prevSlider1 = dev.slider1;
+			info.stats = dev.timing.Summarize();
+		}
+
+		return devices;
+	}
+
+	void Context::ResetDeviceStats()
+	{
+		ContextImpl& context = *m_pImpl;
+		for (auto& dev : context.joystickDevices)
+		{
+			dev.timing.Reset();
+		}
+	}
+
+	void Context::LatchLateInput()
+	{
+		ContextImpl& context = *m_pImpl;
+		KSMAXIS_TRACE_SCOPE(trace, "LatchLateInput");
+		detail::CaptureCpuScope cpuScope{ context.capture, context.counters };
+
+		// The first Update() resyncs the devices, so there is nothing to latch before it
+		if (context.initializedDevices == DeviceFlags::None || context.firstUpdate)
+		{
+			return;
 		}
 
-		for (auto& dev : s_mouseDevices)
 		{
-			s_deltaMouse[0] += dev.deltaX;
-			s_deltaMouse[1] += dev.deltaY;
-			dev.deltaX = 0.0;
-			dev.deltaY = 0.0;
+			KSMAXIS_TRACE_SCOPE(runLoopTrace, "RunLoop");
+			CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0, true);
+			context.counters.AddSyscalls(1);
 		}
 
-		s_firstUpdate = false;
+		std::array<AxisValues, kInputModeCount> deltas{};
+		CollectDeltas(context, deltas[0], deltas[1], deltas[2]);
+		context.lateShaper.Shape(context.responseCurves, deltas);
+		for (std::size_t i = 0; i < kInputModeCount; ++i)
+		{
+			const InputMode mode = static_cast<InputMode>(i);
+			context.axisTotals.Add(mode, deltas[i]);
+			context.lateDeltas[i][0] += deltas[i][0];
+			context.lateDeltas[i][1] += deltas[i][1];
+		}
+		context.changeTracker.OnLateInput(deltas);
+	}
+
+	AxisValues Context::GetLateAxisDeltas(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.lateDeltas[static_cast<std::size_t>(mode)];
+	}
+
+	bool Context::WaitForInput(std::uint32_t timeoutMs)
+	{
+		ContextImpl& context = *m_pImpl;
+		KSMAXIS_TRACE_SCOPE(trace, "WaitForInput");
+		detail::CaptureCpuScope cpuScope{ context.capture, context.counters };
+
+		const bool ready = RunLoopUntilInput(context, timeoutMs);
+		context.capture.AddWakeup();
+
+		KSMAXIS_TRACE_ARG(trace, "ready", ready);
+		return ready;
+	}
+
+	void Context::SetUpdateBudget(const UpdateBudget& budget)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.updateBudget = budget;
+	}
+
+	UpdateBudget Context::GetUpdateBudget() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.updateBudget;
+	}
+
+	bool Context::WasUpdateTruncated() const
+	{
+		return false;
+	}
+
+	UpdateStats Context::GetUpdateStats() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.counters.GetStats();
 	}
 
-	AxisValues GetAxisDeltas(InputMode mode)
+	void Context::ResetUpdateStats()
 	{
+		ContextImpl& context = *m_pImpl;
+		context.counters.Reset();
+	}
+
+	std::size_t Context::GetDeviceCounters(std::span<DeviceCounters> counters) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.deviceCounters.Read(counters);
+	}
+
+	void Context::AddInputWaiter(std::coroutine_handle<> handle)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.inputWaiters.Add(handle);
+	}
+
+	void Context::SetCapturePolicy(const CapturePolicy& policy)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.capture.SetPolicy(policy);
+	}
+
+	CapturePolicy Context::GetCapturePolicy() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.capture.GetPolicy();
+	}
+
+	CaptureState Context::GetCaptureState() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.capture.GetState();
+	}
+
+	CaptureStats Context::GetCaptureStats() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.capture.GetStats();
+	}
+
+	void Context::ResetCaptureStats()
+	{
+		ContextImpl& context = *m_pImpl;
+		context.capture.ResetStats();
+	}
+
+	AxisValues Context::GetAxisDeltas(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
 		if (mode == InputMode::kAnalogStick)
 		{
-			return s_deltaAnalogStick;
+			return context.deltaAnalogStick;
 		}
 		else if (mode == InputMode::kMouse)
 		{
-			return s_deltaMouse;
+			return context.deltaMouse;
 		}
 		else
 		{
-			return s_deltaSlider;
+			return context.deltaSlider;
 		}
 	}
+
+	AxisValues Context::GetAxisTotals(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.axisTotals.Get(mode);
+	}
+
+	std::uint32_t Context::GetChangedModes() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.changeTracker.GetChangedModes();
+	}
+
+	std::uint64_t Context::GetChangeGeneration() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.changeTracker.GetGeneration();
+	}
+
+	std::uint64_t Context::GetChangeGeneration(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.changeTracker.GetGeneration(mode);
+	}
+
+	bool Context::SetResponseCurve(InputMode mode, const ResponseCurve& curve, std::string* pErrorString)
+	{
+		ContextImpl& context = *m_pImpl;
+		ResponseCurveTable table;
+		if (!CompileResponseCurve(curve, table, pErrorString))
+		{
+			return false;
+		}
+		context.responseCurves.Set(mode, table);
+		return true;
+	}
+
+	void Context::SetResponseCurve(InputMode mode, const ResponseCurveTable& table)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.responseCurves.Set(mode, table);
+	}
+
+	void Context::ClearResponseCurve(InputMode mode)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.responseCurves.Clear(mode);
+	}
+
+	void Context::SetTickInterval(std::uint32_t tickUs)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.tickResampler.SetTickInterval(tickUs);
+	}
+
+	std::span<const AxisValues> Context::GetTickDeltas(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.tickResampler.GetTicks(mode);
+	}
+
+	std::int64_t Context::GetFirstTickTimeNs() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.tickResampler.GetFirstTickTimeNs();
+	}
 }
 
 #endif
@@ -0,0 +1,152 @@
+﻿#pragma once
+#include "ksmaxis/ksmaxis.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ksmaxis::detail
+{
+	// Set of active InputModes (see Context::SetActiveInputModes()), one bit per mode
+	class InputModeSet
+	{
+	public:
+		constexpr InputModeSet() noexcept = default;
+
+		[[nodiscard]]
+		static constexpr InputModeSet All() noexcept
+		{
+			InputModeSet modes;
+			modes.Add(InputMode::kAnalogStick);
+			modes.Add(InputMode::kSlider);
+			modes.Add(InputMode::kMouse);
+			return modes;
+		}
+
+		[[nodiscard]]
+		static InputModeSet FromList(const std::vector<InputMode>& modeList) noexcept
+		{
+			InputModeSet modes;
+			for (InputMode mode : modeList)
+			{
+				modes.Add(mode);
+			}
+			return modes;
+		}
+
+		constexpr void Add(InputMode mode) noexcept
+		{
+			m_bits |= Bit(mode);
+		}
+
+		[[nodiscard]]
+		constexpr bool Contains(InputMode mode) const noexcept
+		{
+			return (m_bits & Bit(mode)) != 0;
+		}
+
+		// Union of GetRequiredDeviceFlags() over the contained modes
+		[[nodiscard]]
+		constexpr DeviceFlags GetRequiredDeviceFlags() const noexcept
+		{
+			DeviceFlags deviceFlags = DeviceFlags::None;
+			for (InputMode mode : { InputMode::kAnalogStick, InputMode::kSlider, InputMode::kMouse })
+			{
+				if (Contains(mode))
+				{
+					deviceFlags |= ksmaxis::GetRequiredDeviceFlags(mode);
+				}
+			}
+			return deviceFlags;
+		}
+
+	private:
+		static constexpr std::uint32_t Bit(InputMode mode) noexcept
+		{
+			return InputModeBit(mode);
+		}
+
+		std::uint32_t m_bits = 0;
+	};
+
+	// Running sums of the Update() deltas behind GetAxisTotals(), indexed by InputMode
+	class AxisTotals
+	{
+	public:
+		void Add(InputMode mode, const AxisValues& deltas) noexcept
+		{
+			AxisValues& totals = m_totals[static_cast<std::size_t>(mode)];
+			totals[0] += deltas[0];
+			totals[1] += deltas[1];
+		}
+
+		[[nodiscard]]
+		const AxisValues& Get(InputMode mode) const noexcept
+		{
+			return m_totals[static_cast<std::size_t>(mode)];
+		}
+
+	private:
+		std::array<AxisValues, kInputModeCount> m_totals{};
+	};
+
+	// Dirty mask and generation counters behind GetChangedModes() and GetChangeGeneration()
+	class ChangeTracker
+	{
+	public:
+		// Records which deltas of one Update() (indexed by InputMode) are non-zero
+		void OnUpdate(const std::array<AxisValues, kInputModeCount>& deltas) noexcept
+		{
+			m_changedModes = 0;
+			OnLateInput(deltas);
+		}
+
+		// Adds the modes moved by LatchLateInput() to those of the last Update()
+		void OnLateInput(const std::array<AxisValues, kInputModeCount>& deltas) noexcept
+		{
+			std::uint32_t changedModes = 0;
+			for (std::size_t i = 0; i < kInputModeCount; ++i)
+			{
+				if (deltas[i] != AxisValues{ 0.0, 0.0 })
+				{
+					changedModes |= InputModeBit(static_cast<InputMode>(i));
+					++m_modeGenerations[i];
+				}
+			}
+			if (changedModes != 0)
+			{
+				m_changedModes |= changedModes;
+				++m_generation;
+			}
+		}
+
+		// For Update() calls that return before reading any device
+		void ClearChangedModes() noexcept
+		{
+			m_changedModes = 0;
+		}
+
+		[[nodiscard]]
+		std::uint32_t GetChangedModes() const noexcept
+		{
+			return m_changedModes;
+		}
+
+		[[nodiscard]]
+		std::uint64_t GetGeneration() const noexcept
+		{
+			return m_generation;
+		}
+
+		[[nodiscard]]
+		std::uint64_t GetGeneration(InputMode mode) const noexcept
+		{
+			return m_modeGenerations[static_cast<std::size_t>(mode)];
+		}
+
+	private:
+		std::uint32_t m_changedModes = 0;
+		std::uint64_t m_generation = 0;
+		std::array<std::uint64_t, kInputModeCount> m_modeGenerations{};
+	};
+}
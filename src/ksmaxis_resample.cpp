@@ -0,0 +1,119 @@
+﻿#include "ksmaxis_resample.hpp"
+
+#include <algorithm>
+
+namespace ksmaxis::detail
+{
+	void TickResampler::SetTickInterval(std::uint32_t tickUs) noexcept
+	{
+		m_tickUs = tickUs;
+		m_tickNs = static_cast<std::int64_t>(tickUs) * 1000;
+		m_nextTick = -1;
+		m_carry = {};
+		m_inFrame = false;
+		ClearTicks();
+	}
+
+	void TickResampler::BeginFrame(std::int64_t nowNs) noexcept
+	{
+		ClearTicks();
+		if (m_tickNs <= 0)
+		{
+			return;
+		}
+
+		const std::int64_t nowTick = nowNs / m_tickNs;
+		if (m_nextTick < 0)
+		{
+			m_nextTick = nowTick;
+		}
+
+		// Update() called again within the tick returned last time
+		if (nowTick < m_nextTick)
+		{
+			m_tickCount = 0;
+			m_inFrame = true;
+			return;
+		}
+
+		m_firstTick = std::max(m_nextTick, nowTick - static_cast<std::int64_t>(kMaxTicks) + 1);
+		m_tickCount = static_cast<std::size_t>(nowTick - m_firstTick + 1);
+		m_nextTick = nowTick + 1;
+		m_inFrame = true;
+	}
+
+	void TickResampler::Add(InputMode mode, std::int64_t timeNs, double deltaX, double deltaY) noexcept
+	{
+		if (!m_inFrame || m_tickCount == 0 || (deltaX == 0.0 && deltaY == 0.0))
+		{
+			return;
+		}
+
+		const std::int64_t tick = std::clamp(timeNs / m_tickNs, m_firstTick, m_firstTick + static_cast<std::int64_t>(m_tickCount) - 1);
+		AxisValues& bin = m_ticks[static_cast<std::size_t>(mode)][static_cast<std::size_t>(tick - m_firstTick)];
+		bin[0] += deltaX;
+		bin[1] += deltaY;
+
+		AxisValues& sum = m_binnedSums[static_cast<std::size_t>(mode)];
+		sum[0] += deltaX;
+		sum[1] += deltaY;
+	}
+
+	void TickResampler::EndFrame(const std::array<AxisValues, kInputModeCount>& rawDeltas, const std::array<AxisValues, kInputModeCount>& frameDeltas) noexcept
+	{
+		if (!m_inFrame)
+		{
+			return;
+		}
+		m_inFrame = false;
+
+		for (std::size_t mode = 0; mode < kInputModeCount; ++mode)
+		{
+			AxisValues& carry = m_carry[mode];
+			for (std::size_t axis = 0; axis < 2; ++axis)
+			{
+				if (m_tickCount == 0)
+				{
+					carry[axis] += frameDeltas[mode][axis];
+					continue;
+				}
+
+				double binnedSum = m_binnedSums[mode][axis];
+				const double rawDelta = rawDeltas[mode][axis];
+				if (rawDelta != 0.0 && rawDelta != frameDeltas[mode][axis])
+				{
+					const double gain = frameDeltas[mode][axis] / rawDelta;
+					for (std::size_t tick = 0; tick < m_tickCount; ++tick)
+					{
+						m_ticks[mode][tick][axis] *= gain;
+					}
+					binnedSum *= gain;
+				}
+
+				m_ticks[mode][0][axis] += carry[axis];
+				m_ticks[mode][m_tickCount - 1][axis] += frameDeltas[mode][axis] - binnedSum;
+				carry[axis] = 0.0;
+			}
+		}
+	}
+
+	void TickResampler::ClearTicks() noexcept
+	{
+		for (std::size_t mode = 0; mode < kInputModeCount; ++mode)
+		{
+			std::fill_n(m_ticks[mode].begin(), m_tickCount, AxisValues{ 0.0, 0.0 });
+		}
+		m_binnedSums = {};
+		m_tickCount = 0;
+	}
+
+	std::span<const AxisValues> TickResampler::GetTicks(InputMode mode) const noexcept
+	{
+		return { m_ticks[static_cast<std::size_t>(mode)].data(), m_tickCount };
+	}
+
+	std::int64_t TickResampler::GetFirstTickTimeNs() const noexcept
+	{
+		return m_firstTick * m_tickNs;
+	}
+}
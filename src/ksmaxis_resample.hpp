@@ -0,0 +1,61 @@
+﻿#pragma once
+#include "ksmaxis/ksmaxis.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace ksmaxis::detail
+{
+	// Bins the timestamped deltas of each Update() into fixed ticks on the GetMonotonicTimeNs() grid
+	// (tick k covers [k * interval, (k + 1) * interval)). See Context::SetTickInterval().
+	class TickResampler
+	{
+	public:
+		// Ticks returned by one Update(); older ticks of a longer stall are merged into the first one
+		static constexpr std::size_t kMaxTicks = 1024;
+
+		// 0 disables resampling. Restarts the grid.
+		void SetTickInterval(std::uint32_t tickUs) noexcept;
+
+		[[nodiscard]]
+		std::uint32_t GetTickInterval() const noexcept
+		{
+			return m_tickUs;
+		}
+
+		// Starts binning the deltas of one Update(): the ticks after the last one returned, up to the one containing
+		// nowNs. Add() is ignored outside BeginFrame()/EndFrame(), e.g. during the first Update() that discards deltas.
+		void BeginFrame(std::int64_t nowNs) noexcept;
+
+		// timeNs is when the input happened, clamped into the ticks of the frame
+		void Add(InputMode mode, std::int64_t timeNs, double deltaX, double deltaY) noexcept;
+
+		// Reconciles each mode with its frame delta, so that the ticks sum to exactly what GetAxisDeltas() reports:
+		// the binned input is scaled by the response curve's gain over the frame (frameDeltas / rawDeltas), input the
+		// backend didn't timestamp lands in the last tick, and a frame that completes no tick is carried into the
+		// first tick of the next one.
+		void EndFrame(const std::array<AxisValues, kInputModeCount>& rawDeltas, const std::array<AxisValues, kInputModeCount>& frameDeltas) noexcept;
+
+		// Clears the ticks of the previous frame, for Update() calls that bin nothing
+		void ClearTicks() noexcept;
+
+		[[nodiscard]]
+		std::span<const AxisValues> GetTicks(InputMode mode) const noexcept;
+
+		[[nodiscard]]
+		std::int64_t GetFirstTickTimeNs() const noexcept;
+
+	private:
+		std::uint32_t m_tickUs = 0;
+		std::int64_t m_tickNs = 0;
+		std::int64_t m_nextTick = -1; // First tick of the next frame (-1: starts at the tick of the next frame)
+		std::int64_t m_firstTick = 0;
+		std::size_t m_tickCount = 0;
+		bool m_inFrame = false;
+		std::array<std::array<AxisValues, kMaxTicks>, kInputModeCount> m_ticks{};
+		std::array<AxisValues, kInputModeCount> m_binnedSums{};
+		std::array<AxisValues, kInputModeCount> m_carry{};
+	};
+}
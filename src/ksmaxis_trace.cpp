@@ -0,0 +1,227 @@
+﻿#include "ksmaxis/ksmaxis.hpp"
+#include "ksmaxis_trace.hpp"
+
+#ifdef KSMAXIS_TRACE
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace ksmaxis
+{
+	namespace
+	{
+		// Fixed ring of completed spans; the oldest spans are overwritten once it is full
+		constexpr std::size_t kTraceCapacity = 16384;
+		constexpr std::size_t kTraceLabelSize = 48;
+		constexpr int kTraceMaxArgs = 2;
+
+		struct TraceEvent
+		{
+			const char* name = nullptr;
+			char label[kTraceLabelSize] = {};
+			std::int64_t beginNs = 0;
+			std::int64_t durationNs = 0;
+			std::uint32_t threadId = 0;
+			const char* argNames[kTraceMaxArgs] = {};
+			std::int64_t argValues[kTraceMaxArgs] = {};
+			int argCount = 0;
+		};
+
+		std::array<TraceEvent, kTraceCapacity> s_traceEvents;
+		std::atomic<std::uint64_t> s_traceEventCount{ 0 };
+
+		std::int64_t GetTraceTimeNs()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		std::uint32_t GetTraceThreadId()
+		{
+			thread_local const std::uint32_t threadId = static_cast<std::uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+			return threadId;
+		}
+
+		int GetTraceProcessId()
+		{
+#ifdef _WIN32
+			return _getpid();
+#else
+			return static_cast<int>(getpid());
+#endif
+		}
+
+		void WriteJsonString(std::FILE* fp, const char* str)
+		{
+			std::fputc('"', fp);
+			for (const char* p = str; *p; ++p)
+			{
+				const unsigned char c = static_cast<unsigned char>(*p);
+				if (c == '"' || c == '\\')
+				{
+					std::fputc('\\', fp);
+					std::fputc(c, fp);
+				}
+				else if (c < 0x20)
+				{
+					std::fprintf(fp, "\\u%04x", c);
+				}
+				else
+				{
+					std::fputc(c, fp);
+				}
+			}
+			std::fputc('"', fp);
+		}
+	}
+
+	namespace detail
+	{
+		TraceScope::TraceScope(const char* name) noexcept
+			: m_name(name)
+			, m_beginNs(GetTraceTimeNs())
+		{
+		}
+
+		TraceScope::~TraceScope()
+		{
+			const std::int64_t endNs = GetTraceTimeNs();
+			const std::uint64_t index = s_traceEventCount.fetch_add(1, std::memory_order_relaxed);
+
+			TraceEvent& event = s_traceEvents[index % kTraceCapacity];
+			event.name = m_name;
+			event.beginNs = m_beginNs;
+			event.durationNs = endNs - m_beginNs;
+			event.threadId = GetTraceThreadId();
+			if (m_label)
+			{
+				std::strncpy(event.label, m_label, kTraceLabelSize - 1);
+				event.label[kTraceLabelSize - 1] = '\0';
+			}
+			else
+			{
+				event.label[0] = '\0';
+			}
+			for (int i = 0; i < m_argCount; ++i)
+			{
+				event.argNames[i] = m_argNames[i];
+				event.argValues[i] = m_argValues[i];
+			}
+			event.argCount = m_argCount;
+		}
+
+		void TraceScope::SetLabel(const char* label) noexcept
+		{
+			m_label = label;
+		}
+
+		void TraceScope::AddArg(const char* name, std::int64_t value) noexcept
+		{
+			if (m_argCount < kMaxArgs)
+			{
+				m_argNames[m_argCount] = name;
+				m_argValues[m_argCount] = value;
+				++m_argCount;
+			}
+		}
+	}
+
+	bool WriteTrace(const std::string& filePath, std::string* pErrorString)
+	{
+		std::FILE* fp = std::fopen(filePath.c_str(), "wb");
+		if (!fp)
+		{
+			if (pErrorString)
+			{
+				*pErrorString = "Failed to open trace file: " + filePath;
+			}
+			return false;
+		}
+
+		const std::uint64_t count = s_traceEventCount.load(std::memory_order_acquire);
+		const std::uint64_t first = count > kTraceCapacity ? count - kTraceCapacity : 0;
+		const int processId = GetTraceProcessId();
+
+		// Chrome trace event format (also accepted by Perfetto); ts/dur are steady_clock microseconds
+		std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", fp);
+		for (std::uint64_t i = first; i < count; ++i)
+		{
+			const TraceEvent& event = s_traceEvents[i % kTraceCapacity];
+			if (i != first)
+			{
+				std::fputc(',', fp);
+			}
+			std::fputs("\n{\"name\":", fp);
+			WriteJsonString(fp, event.name ? event.name : "");
+			std::fprintf(fp, ",\"cat\":\"ksmaxis\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u,\"args\":{",
+				static_cast<double>(event.beginNs) / 1000.0,
+				static_cast<double>(event.durationNs) / 1000.0,
+				processId,
+				static_cast<unsigned>(event.threadId));
+
+			bool firstArg = true;
+			if (event.label[0] != '\0')
+			{
+				std::fputs("\"device\":", fp);
+				WriteJsonString(fp, event.label);
+				firstArg = false;
+			}
+			for (int j = 0; j < event.argCount; ++j)
+			{
+				if (!firstArg)
+				{
+					std::fputc(',', fp);
+				}
+				WriteJsonString(fp, event.argNames[j]);
+				std::fprintf(fp, ":%lld", static_cast<long long>(event.argValues[j]));
+				firstArg = false;
+			}
+			std::fputs("}}", fp);
+		}
+		std::fputs("\n]}\n", fp);
+
+		const bool succeeded = std::ferror(fp) == 0;
+		std::fclose(fp);
+		if (!succeeded && pErrorString)
+		{
+			*pErrorString = "Failed to write trace file: " + filePath;
+		}
+		return succeeded;
+	}
+
+	void ClearTrace()
+	{
+		s_traceEventCount.store(0, std::memory_order_release);
+	}
+}
+
+#else
+
+namespace ksmaxis
+{
+	bool WriteTrace(const std::string& filePath, std::string* pErrorString)
+	{
+		(void)filePath;
+		if (pErrorString)
+		{
+			*pErrorString = "Tracing is disabled (build with KSMAXIS_TRACE)";
+		}
+		return false;
+	}
+
+	void ClearTrace()
+	{
+	}
+}
+
+#endif
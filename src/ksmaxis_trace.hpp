@@ -0,0 +1,47 @@
+﻿#pragma once
+#include <cstdint>
+
+// Internal tracing spans, compiled out unless KSMAXIS_TRACE is defined
+#ifdef KSMAXIS_TRACE
+
+namespace ksmaxis::detail
+{
+	class TraceScope
+	{
+	public:
+		explicit TraceScope(const char* name) noexcept;
+
+		~TraceScope();
+
+		TraceScope(const TraceScope&) = delete;
+
+		TraceScope& operator=(const TraceScope&) = delete;
+
+		// Pointers must stay valid until the scope ends (the label is copied, names are not)
+		void SetLabel(const char* label) noexcept;
+
+		void AddArg(const char* name, std::int64_t value) noexcept;
+
+	private:
+		static constexpr int kMaxArgs = 2;
+
+		const char* m_name;
+		const char* m_label = nullptr;
+		std::int64_t m_beginNs;
+		const char* m_argNames[kMaxArgs] = {};
+		std::int64_t m_argValues[kMaxArgs] = {};
+		int m_argCount = 0;
+	};
+}
+
+#define KSMAXIS_TRACE_SCOPE(var, name) ::ksmaxis::detail::TraceScope var{ name }
+#define KSMAXIS_TRACE_LABEL(var, label) var.SetLabel(label)
+#define KSMAXIS_TRACE_ARG(var, name, value) var.AddArg(name, static_cast<std::int64_t>(value))
+
+#else
+
+#define KSMAXIS_TRACE_SCOPE(var, name) ((void)0)
+#define KSMAXIS_TRACE_LABEL(var, label) ((void)0)
+#define KSMAXIS_TRACE_ARG(var, name, value) ((void)(value))
+
+#endif
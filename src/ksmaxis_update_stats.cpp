@@ -0,0 +1,57 @@
+﻿#include "ksmaxis_update_stats.hpp"
+
+namespace ksmaxis::detail
+{
+	namespace
+	{
+		// Weight of the newest sample in the EWMA (1/16)
+		constexpr std::uint64_t kEwmaShift = 4;
+	}
+
+	void UpdateCounters::AddUpdateDuration(std::uint64_t durationNs) noexcept
+	{
+		// Only the Update() thread writes, so plain load/store pairs are enough here
+		const std::uint64_t updateCount = m_updateCount.load(std::memory_order_relaxed);
+		const std::uint64_t ewma = m_ewmaUpdateNs.load(std::memory_order_relaxed);
+		const std::uint64_t newEwma = updateCount == 0 ? durationNs : ewma - (ewma >> kEwmaShift) + (durationNs >> kEwmaShift);
+
+		m_lastUpdateNs.store(durationNs, std::memory_order_relaxed);
+		m_ewmaUpdateNs.store(newEwma, std::memory_order_relaxed);
+		if (durationNs > m_maxUpdateNs.load(std::memory_order_relaxed))
+		{
+			m_maxUpdateNs.store(durationNs, std::memory_order_relaxed);
+		}
+		m_updateCount.store(updateCount + 1, std::memory_order_relaxed);
+	}
+
+	UpdateStats UpdateCounters::GetStats() const noexcept
+	{
+		UpdateStats stats;
+		stats.updateCount = m_updateCount.load(std::memory_order_relaxed);
+		stats.lastUpdateNs = m_lastUpdateNs.load(std::memory_order_relaxed);
+		stats.ewmaUpdateNs = m_ewmaUpdateNs.load(std::memory_order_relaxed);
+		stats.maxUpdateNs = m_maxUpdateNs.load(std::memory_order_relaxed);
+		stats.syscallCount = m_syscallCount.load(std::memory_order_relaxed);
+		stats.eventCount = m_eventCount.load(std::memory_order_relaxed);
+		stats.rescanCount = m_rescanCount.load(std::memory_order_relaxed);
+		stats.x11EventCount = m_x11EventCount.load(std::memory_order_relaxed);
+		stats.waylandEventCount = m_waylandEventCount.load(std::memory_order_relaxed);
+		stats.truncatedUpdateCount = m_truncatedUpdateCount.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	void UpdateCounters::Reset() noexcept
+	{
+		// A concurrent Update() may land partly before and partly after the reset; counters stay monotonic afterwards
+		m_updateCount.store(0, std::memory_order_relaxed);
+		m_lastUpdateNs.store(0, std::memory_order_relaxed);
+		m_ewmaUpdateNs.store(0, std::memory_order_relaxed);
+		m_maxUpdateNs.store(0, std::memory_order_relaxed);
+		m_syscallCount.store(0, std::memory_order_relaxed);
+		m_eventCount.store(0, std::memory_order_relaxed);
+		m_rescanCount.store(0, std::memory_order_relaxed);
+		m_x11EventCount.store(0, std::memory_order_relaxed);
+		m_waylandEventCount.store(0, std::memory_order_relaxed);
+		m_truncatedUpdateCount.store(0, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,101 @@
+﻿#pragma once
+#include "ksmaxis/ksmaxis.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace ksmaxis::detail
+{
+	// Counters behind GetUpdateStats(). Written by the thread calling Update(), readable from any thread.
+	class UpdateCounters
+	{
+	public:
+		void AddSyscalls(std::uint64_t count) noexcept
+		{
+			m_syscallCount.fetch_add(count, std::memory_order_relaxed);
+		}
+
+		void AddEvents(std::uint64_t count) noexcept
+		{
+			m_eventCount.fetch_add(count, std::memory_order_relaxed);
+		}
+
+		void AddRescan() noexcept
+		{
+			m_rescanCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void AddX11Events(std::uint64_t count) noexcept
+		{
+			m_x11EventCount.fetch_add(count, std::memory_order_relaxed);
+		}
+
+		void AddWaylandEvents(std::uint64_t count) noexcept
+		{
+			m_waylandEventCount.fetch_add(count, std::memory_order_relaxed);
+		}
+
+		void AddTruncatedUpdate() noexcept
+		{
+			m_truncatedUpdateCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void AddUpdateDuration(std::uint64_t durationNs) noexcept;
+
+		[[nodiscard]]
+		UpdateStats GetStats() const noexcept;
+
+		void Reset() noexcept;
+
+	private:
+		std::atomic<std::uint64_t> m_updateCount{ 0 };
+		std::atomic<std::uint64_t> m_lastUpdateNs{ 0 };
+		std::atomic<std::uint64_t> m_ewmaUpdateNs{ 0 };
+		std::atomic<std::uint64_t> m_maxUpdateNs{ 0 };
+		std::atomic<std::uint64_t> m_syscallCount{ 0 };
+		std::atomic<std::uint64_t> m_eventCount{ 0 };
+		std::atomic<std::uint64_t> m_rescanCount{ 0 };
+		std::atomic<std::uint64_t> m_x11EventCount{ 0 };
+		std::atomic<std::uint64_t> m_waylandEventCount{ 0 };
+		std::atomic<std::uint64_t> m_truncatedUpdateCount{ 0 };
+	};
+
+	// Measures the wall time of Update()
+	class UpdateDurationScope
+	{
+	public:
+		explicit UpdateDurationScope(UpdateCounters& counters) noexcept
+			: m_counters(counters)
+			, m_startTime(std::chrono::steady_clock::now())
+		{
+		}
+
+		~UpdateDurationScope()
+		{
+			Stop();
+		}
+
+		// Ends the measurement early, e.g. before resuming coroutines awaiting NextInput()
+		void Stop() noexcept
+		{
+			if (m_stopped)
+			{
+				return;
+			}
+			m_stopped = true;
+
+			const auto duration = std::chrono::steady_clock::now() - m_startTime;
+			m_counters.AddUpdateDuration(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()));
+		}
+
+		UpdateDurationScope(const UpdateDurationScope&) = delete;
+
+		UpdateDurationScope& operator=(const UpdateDurationScope&) = delete;
+
+	private:
+		UpdateCounters& m_counters;
+		std::chrono::steady_clock::time_point m_startTime;
+		bool m_stopped = false;
+	};
+}
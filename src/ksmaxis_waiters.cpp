@@ -0,0 +1,28 @@
+﻿#include "ksmaxis_waiters.hpp"
+
+namespace ksmaxis::detail
+{
+	void InputWaiterList::Add(std::coroutine_handle<> handle)
+	{
+		m_handles.push_back(handle);
+	}
+
+	void InputWaiterList::ResumeAll()
+	{
+		// Update() called from a resumed coroutine leaves new waiters to the next top-level Update()
+		if (m_handles.empty() || m_isResuming)
+		{
+			return;
+		}
+
+		// Swap first: a resumed coroutine that awaits again waits for the next Update() with input
+		m_isResuming = true;
+		m_resuming.swap(m_handles);
+		for (const auto handle : m_resuming)
+		{
+			handle.resume();
+		}
+		m_resuming.clear();
+		m_isResuming = false;
+	}
+}
@@ -0,0 +1,20 @@
+﻿#pragma once
+#include <coroutine>
+#include <vector>
+
+namespace ksmaxis::detail
+{
+	// Coroutines suspended in co_await Context::NextInput(), resumed by the Update() that produces input
+	class InputWaiterList
+	{
+	public:
+		void Add(std::coroutine_handle<> handle);
+
+		void ResumeAll();
+
+	private:
+		std::vector<std::coroutine_handle<>> m_handles;
+		std::vector<std::coroutine_handle<>> m_resuming;
+		bool m_isResuming = false;
+	};
+}
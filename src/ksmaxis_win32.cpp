@@ -10,8 +10,20 @@
 #include <dinput.h>
 
 #include "ksmaxis/ksmaxis.hpp"
+#include "ksmaxis_trace.hpp"
+#include "ksmaxis_capture.hpp"
+#include "ksmaxis_device_stats.hpp"
+#include "ksmaxis_axis.hpp"
+#include "ksmaxis_modes.hpp"
+#include "ksmaxis_update_stats.hpp"
+#include "ksmaxis_budget.hpp"
+#include "ksmaxis_waiters.hpp"
+#include "ksmaxis_resample.hpp"
+#include "ksmaxis_curve.hpp"
 
 #include <vector>
+#include <algorithm>
+#include <chrono>
 #include <comdef.h>
 
 #pragma comment(lib, "dinput8.lib")
@@ -19,10 +31,24 @@
 
 namespace ksmaxis
 {
+	using detail::ApplyAxisValue;
+	using detail::AxisTotals;
+	using detail::ChangeTracker;
+	using detail::DeviceCounterTable;
+	using detail::DeviceTimingAccumulator;
+	using detail::GetMonotonicTimeNs;
+	using detail::InputModeSet;
+	using detail::LateDeltaShaper;
+	using detail::ResponseCurveSet;
+	using detail::TickResampler;
+	using detail::UpdateBudgetScope;
+	using detail::UpdateCounters;
+
 	namespace
 	{
-		// Wrap-around detection threshold (half of normalized range)
-		constexpr double kWrapThreshold = 0.5;
+		// DirectInput event buffer per device, and number of records read per GetDeviceData() call
+		constexpr DWORD kDeviceDataBufferSize = 256;
+		constexpr DWORD kDeviceDataReadCount = 64;
 
 		struct JoystickDevice
 		{
@@ -32,47 +58,85 @@ namespace ksmaxis
 			double axisY = 0.0;
 			double slider0 = 0.0;
 			double slider1 = 0.0;
-			double prevAxisX = 0.0;
-			double prevAxisY = 0.0;
-			double prevSlider0 = 0.0;
-			double prevSlider1 = 0.0;
+			// Wrap-corrected deltas accumulated per buffered event since the last Update()
+			double deltaAxisX = 0.0;
+			double deltaAxisY = 0.0;
+			double deltaSlider0 = 0.0;
+			double deltaSlider1 = 0.0;
+			DWORD lastSequence = 0;
+			DeviceTimingAccumulator timing;
 			bool opened = false;
 		};
+	}
 
-		LPDIRECTINPUT8W s_directInput = nullptr;
-		std::vector<JoystickDevice> s_joystickDevices;
-		DeviceFlags s_initializedDevices = DeviceFlags::None;
-		bool s_firstUpdate = true;
-		AxisValues s_deltaAnalogStick = { 0.0, 0.0 };
-		AxisValues s_deltaSlider = { 0.0, 0.0 };
-		AxisValues s_deltaMouse = { 0.0, 0.0 };
-		AxisValues s_mouseAccumulator = { 0.0, 0.0 };
+	namespace detail
+	{
+		// State owned by a Context (no process-global mutable state)
+		struct ContextImpl
+		{
+			LPDIRECTINPUT8W directInput = nullptr;
+			// Declared before the device list, whose devices free their counter slots when destroyed
+			DeviceCounterTable deviceCounters;
+			std::vector<JoystickDevice> joystickDevices;
+			DeviceFlags initializedDevices = DeviceFlags::None;
+			DeviceFlags requestedDevices = DeviceFlags::None; // Passed to Init(), including devices deferred by activeModes
+			InputModeSet activeModes = InputModeSet::All();
+			HWND cooperativeWnd = nullptr; // hWnd passed to Init(), kept for devices opened later
+			bool firstUpdate = true;
+			AxisValues deltaAnalogStick = { 0.0, 0.0 };
+			AxisValues deltaSlider = { 0.0, 0.0 };
+			AxisValues deltaMouse = { 0.0, 0.0 };
+			AxisTotals axisTotals;
+			ChangeTracker changeTracker;
+			ResponseCurveSet responseCurves;
+			TickResampler tickResampler;
+			std::array<AxisValues, kInputModeCount> lateDeltas{}; // See LatchLateInput()
+			LateDeltaShaper lateShaper;
+			AxisValues mouseAccumulator = { 0.0, 0.0 };
 
-		HWND s_hiddenWnd = nullptr;
-		ATOM s_windowClass = 0;
+			HWND hiddenWnd = nullptr;
+			ATOM windowClass = 0;
 
+			// Auto-reset event signaled by DirectInput when any joystick has new data
+			HANDLE inputEvent = nullptr;
+			CaptureTracker capture;
+			UpdateCounters counters;
+			UpdateBudget updateBudget;
+			bool lastUpdateTruncated = false;
+			std::size_t drainStartSource = 0; // See DrainInputSources()
+			detail::InputWaiterList inputWaiters;
+		};
+	}
+
+	using detail::ContextImpl;
+
+	namespace
+	{
 		constexpr wchar_t kWindowClassName[] = L"ksmaxis_RawInputWindow";
 
 		LRESULT CALLBACK RawInputWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 		{
 			if (msg == WM_INPUT)
 			{
+				// Set right after the window is created (see InitRawInputWindow)
+				auto* pContext = reinterpret_cast<ContextImpl*>(GetWindowLongPtrW(hWnd, GWLP_USERDATA));
+
 				UINT size = 0;
 				GetRawInputData(reinterpret_cast<HRAWINPUT>(lParam), RID_INPUT, nullptr, &size, sizeof(RAWINPUTHEADER));
 
-				if (size > 0)
+				// Only mice are registered, so the packet always fits a RAWINPUT (no per-message allocation)
+				RAWINPUT raw{};
+				if (pContext && size > 0 && size <= sizeof(raw))
 				{
-					std::vector<BYTE> buffer(size);
-					if (GetRawInputData(reinterpret_cast<HRAWINPUT>(lParam), RID_INPUT, buffer.data(), &size, sizeof(RAWINPUTHEADER)) == size)
+					if (GetRawInputData(reinterpret_cast<HRAWINPUT>(lParam), RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == size)
 					{
-						RAWINPUT* raw = reinterpret_cast<RAWINPUT*>(buffer.data());
-						if (raw->header.dwType == RIM_TYPEMOUSE)
+						if (raw.header.dwType == RIM_TYPEMOUSE)
 						{
 							// Only handle relative mouse movement
-							if ((raw->data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE) == 0)
+							if ((raw.data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE) == 0)
 							{
-								s_mouseAccumulator[0] += static_cast<double>(raw->data.mouse.lLastX);
-								s_mouseAccumulator[1] += static_cast<double>(raw->data.mouse.lLastY);
+								pContext->mouseAccumulator[0] += static_cast<double>(raw.data.mouse.lLastX);
+								pContext->mouseAccumulator[1] += static_cast<double>(raw.data.mouse.lLastY);
 							}
 						}
 					}
@@ -88,47 +152,128 @@ namespace ksmaxis
 			return (static_cast<double>(value) + 32768.0) / 65535.0;
 		}
 
-		double CalculateDelta(double current, double prev)
+		// Applies buffered axis events one by one so that fast spins between two Update() calls don't alias.
+		// Returns false if buffered data was lost (overflow or read failure), in which case the caller resyncs from
+		// the device state. Records left over when the budget runs out stay in the DirectInput buffer. Each record is
+		// binned into the ticks by its own timestamp.
+		bool DrainBufferedJoystickData(JoystickDevice& dev, InputModeSet modes, UpdateCounters& counters, UpdateBudgetScope& budget, TickResampler& resampler)
 		{
-			double delta = current - prev;
+			const bool stickActive = modes.Contains(InputMode::kAnalogStick);
+			const bool sliderActive = modes.Contains(InputMode::kSlider);
 
-			// Wrap-around correction
-			if (delta > kWrapThreshold)
+			DIDEVICEOBJECTDATA data[kDeviceDataReadCount];
+			while (!budget.IsExhausted())
 			{
-				delta -= 1.0;
-			}
-			else if (delta < -kWrapThreshold)
-			{
-				delta += 1.0;
+				const DWORD requestCount = static_cast<DWORD>((std::min)(static_cast<std::uint64_t>(kDeviceDataReadCount), budget.GetRemainingEvents()));
+				DWORD count = requestCount;
+				HRESULT hr = dev.device->GetDeviceData(sizeof(DIDEVICEOBJECTDATA), data, &count, 0);
+				counters.AddSyscalls(1);
+				if (FAILED(hr) || hr == DI_BUFFEROVERFLOW)
+				{
+					if (hr == DI_BUFFEROVERFLOW)
+					{
+						dev.timing.AddDropped();
+					}
+					return false;
+				}
+
+				dev.timing.AddEvents(count);
+				counters.AddEvents(count);
+				budget.AddEvents(count);
+
+				const std::int64_t readTimeNs = GetMonotonicTimeNs();
+				const DWORD readTickCount = GetTickCount();
+				for (DWORD i = 0; i < count; ++i)
+				{
+					// Timestamps are GetTickCount() milliseconds, rebased onto the read time (unsigned subtraction handles
+					// the 49-day wrap). Records sharing a sequence number come from the same report.
+					const std::int64_t reportTimeNs = readTimeNs - static_cast<std::int64_t>(readTickCount - data[i].dwTimeStamp) * 1000000;
+					if (data[i].dwSequence != dev.lastSequence)
+					{
+						dev.lastSequence = data[i].dwSequence;
+						dev.timing.AddReport(reportTimeNs, readTimeNs);
+					}
+
+					// DIJOFS_* aren't constant expressions in C++, so no switch here
+					const DWORD offset = data[i].dwOfs;
+					const double value = Normalize(static_cast<LONG>(data[i].dwData));
+					if (offset == DIJOFS_X)
+					{
+						double delta = 0.0;
+						ApplyAxisValue(value, dev.axisX, delta, stickActive);
+						dev.deltaAxisX += delta;
+						resampler.Add(InputMode::kAnalogStick, reportTimeNs, delta, 0.0);
+					}
+					else if (offset == DIJOFS_Y)
+					{
+						double delta = 0.0;
+						ApplyAxisValue(value, dev.axisY, delta, stickActive);
+						dev.deltaAxisY += delta;
+						resampler.Add(InputMode::kAnalogStick, reportTimeNs, 0.0, delta);
+					}
+					else if (offset == DIJOFS_SLIDER(1)) // Intentionally swapped ([0]=right knob, [1]=left knob)
+					{
+						double delta = 0.0;
+						ApplyAxisValue(value, dev.slider0, delta, sliderActive);
+						dev.deltaSlider0 += delta;
+						resampler.Add(InputMode::kSlider, reportTimeNs, delta, 0.0);
+					}
+					else if (offset == DIJOFS_SLIDER(0))
+					{
+						double delta = 0.0;
+						ApplyAxisValue(value, dev.slider1, delta, sliderActive);
+						dev.deltaSlider1 += delta;
+						resampler.Add(InputMode::kSlider, reportTimeNs, 0.0, delta);
+					}
+				}
+
+				if (count < requestCount)
+				{
+					return true;
+				}
 			}
+			return true;
+		}
 
-			return delta;
+		void FlushBufferedJoystickData(JoystickDevice& dev, UpdateCounters& counters)
+		{
+			DWORD count = INFINITE;
+			dev.device->GetDeviceData(sizeof(DIDEVICEOBJECTDATA), nullptr, &count, 0);
+			counters.AddSyscalls(1);
 		}
 
-		BOOL CALLBACK EnumDevicesCallback(const DIDEVICEINSTANCEW* instance, VOID* context)
+		BOOL CALLBACK EnumDevicesCallback(const DIDEVICEINSTANCEW* instance, VOID* pContext)
 		{
-			(void)context;
 			JoystickDevice dev{};
 			dev.instance = *instance;
-			s_joystickDevices.push_back(dev);
+			static_cast<ContextImpl*>(pContext)->joystickDevices.push_back(std::move(dev));
 			return DIENUM_CONTINUE;
 		}
 
+		std::string WideToUtf8(const wchar_t* str)
+		{
+			int size = WideCharToMultiByte(CP_UTF8, 0, str, -1, nullptr, 0, nullptr, nullptr);
+			if (size <= 0)
+			{
+				return {};
+			}
+			std::string result(size - 1, '\0');
+			WideCharToMultiByte(CP_UTF8, 0, str, -1, &result[0], size, nullptr, nullptr);
+			return result;
+		}
+
 		std::string GetHResultErrorString(HRESULT hr)
 		{
 			_com_error err(hr);
-			const wchar_t* msg = err.ErrorMessage();
-			int size = WideCharToMultiByte(CP_UTF8, 0, msg, -1, nullptr, 0, nullptr, nullptr);
-			if (size <= 0)
+			std::string result = WideToUtf8(err.ErrorMessage());
+			if (result.empty())
 			{
 				return "Unknown error";
 			}
-			std::string result(size - 1, '\0');
-			WideCharToMultiByte(CP_UTF8, 0, msg, -1, &result[0], size, nullptr, nullptr);
 			return result;
 		}
 
-		bool InitRawInputWindow(std::string* pErrorString)
+		bool InitRawInputWindow(ContextImpl& context, std::string* pErrorString)
 		{
 			WNDCLASSEXW wc{};
 			wc.cbSize = sizeof(WNDCLASSEXW);
@@ -136,8 +281,8 @@ namespace ksmaxis
 			wc.hInstance = GetModuleHandle(nullptr);
 			wc.lpszClassName = kWindowClassName;
 
-			s_windowClass = RegisterClassExW(&wc);
-			if (!s_windowClass)
+			context.windowClass = RegisterClassExW(&wc);
+			if (!context.windowClass)
 			{
 				DWORD err = GetLastError();
 				if (err != ERROR_CLASS_ALREADY_EXISTS)
@@ -151,7 +296,7 @@ namespace ksmaxis
 			}
 
 			// Message-only window
-			s_hiddenWnd = CreateWindowExW(
+			context.hiddenWnd = CreateWindowExW(
 				0,
 				kWindowClassName,
 				L"",
@@ -162,7 +307,7 @@ namespace ksmaxis
 				GetModuleHandle(nullptr),
 				nullptr);
 
-			if (!s_hiddenWnd)
+			if (!context.hiddenWnd)
 			{
 				if (pErrorString)
 				{
@@ -171,11 +316,13 @@ namespace ksmaxis
 				return false;
 			}
 
+			SetWindowLongPtrW(context.hiddenWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(&context));
+
 			RAWINPUTDEVICE rid{};
 			rid.usUsagePage = HID_USAGE_PAGE_GENERIC;
 			rid.usUsage = HID_USAGE_GENERIC_MOUSE;
 			rid.dwFlags = RIDEV_INPUTSINK;
-			rid.hwndTarget = s_hiddenWnd;
+			rid.hwndTarget = context.hiddenWnd;
 
 			if (!RegisterRawInputDevices(&rid, 1, sizeof(RAWINPUTDEVICE)))
 			{
@@ -183,274 +330,765 @@ namespace ksmaxis
 				{
 					*pErrorString = "Failed to register raw input device";
 				}
-				DestroyWindow(s_hiddenWnd);
-				s_hiddenWnd = nullptr;
+				DestroyWindow(context.hiddenWnd);
+				context.hiddenWnd = nullptr;
 				return false;
 			}
 
 			return true;
 		}
 
-		void TerminateRawInputWindow()
+		void TerminateRawInputWindow(ContextImpl& context)
 		{
-			if (s_hiddenWnd)
+			if (context.hiddenWnd)
 			{
-				DestroyWindow(s_hiddenWnd);
-				s_hiddenWnd = nullptr;
+				DestroyWindow(context.hiddenWnd);
+				context.hiddenWnd = nullptr;
 			}
 
-			if (s_windowClass)
+			if (context.windowClass)
 			{
 				UnregisterClassW(kWindowClassName, GetModuleHandle(nullptr));
-				s_windowClass = 0;
+				context.windowClass = 0;
 			}
 		}
-	}
-
-	bool Init(DeviceFlags deviceFlags, void* hWnd, std::string* pErrorString, std::vector<std::string>* pWarningStrings)
-	{
-		// Skip already initialized devices
-		deviceFlags = deviceFlags & ~s_initializedDevices;
-		if (deviceFlags == DeviceFlags::None)
-		{
-			return true;
-		}
 
-		// Initialize DirectInput for joysticks
-		if ((deviceFlags & DeviceFlags::Joystick) != DeviceFlags::None)
+		void InitDevices(ContextImpl& context, DeviceFlags deviceFlags, std::vector<std::string>* pWarningStrings)
 		{
-			HRESULT hr = DirectInput8Create(
-				GetModuleHandle(nullptr),
-				DIRECTINPUT_VERSION,
-				IID_IDirectInput8W,
-				reinterpret_cast<void**>(&s_directInput),
-				nullptr);
+			context.capture.Reset(std::chrono::steady_clock::now());
 
-			if (FAILED(hr))
+			// Initialize DirectInput for joysticks
+			if ((deviceFlags & DeviceFlags::Joystick) != DeviceFlags::None)
 			{
-				if (pWarningStrings)
-				{
-					pWarningStrings->push_back(std::string{ "DirectInput8Create failed: " } + GetHResultErrorString(hr));
-				}
-				s_directInput = nullptr;
-			}
+				// Only newly opened joysticks need the first-Update() resync; initializing the mouse alone must not
+				// drop the deltas of joysticks that are already running
+				context.firstUpdate = true;
+				context.inputEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
 
-			if (s_directInput)
-			{
-				hr = s_directInput->EnumDevices(
-					DI8DEVCLASS_GAMECTRL,
-					EnumDevicesCallback,
-					nullptr,
-					DIEDFL_ATTACHEDONLY);
+				HRESULT hr = DirectInput8Create(
+					GetModuleHandle(nullptr),
+					DIRECTINPUT_VERSION,
+					IID_IDirectInput8W,
+					reinterpret_cast<void**>(&context.directInput),
+					nullptr);
 
 				if (FAILED(hr))
 				{
 					if (pWarningStrings)
 					{
-						pWarningStrings->push_back(std::string{ "EnumDevices failed: " } + GetHResultErrorString(hr));
+						pWarningStrings->push_back(std::string{ "DirectInput8Create failed: " } + GetHResultErrorString(hr));
 					}
-					s_directInput->Release();
-					s_directInput = nullptr;
+					context.directInput = nullptr;
 				}
-			}
 
-			// Open all joystick devices
-			if (s_directInput)
-			{
-				for (auto& dev : s_joystickDevices)
+				if (context.directInput)
 				{
-					hr = s_directInput->CreateDevice(dev.instance.guidInstance, &dev.device, nullptr);
-					if (FAILED(hr))
-					{
-						continue;
-					}
+					hr = context.directInput->EnumDevices(
+						DI8DEVCLASS_GAMECTRL,
+						EnumDevicesCallback,
+						&context,
+						DIEDFL_ATTACHEDONLY);
 
-					hr = dev.device->SetDataFormat(&c_dfDIJoystick2);
 					if (FAILED(hr))
 					{
-						dev.device->Release();
-						dev.device = nullptr;
-						continue;
+						if (pWarningStrings)
+						{
+							pWarningStrings->push_back(std::string{ "EnumDevices failed: " } + GetHResultErrorString(hr));
+						}
+						context.directInput->Release();
+						context.directInput = nullptr;
 					}
+				}
 
-					HWND hwndForDInput = static_cast<HWND>(hWnd);
-					if (!hwndForDInput)
+				// Open all joystick devices
+				if (context.directInput)
+				{
+					for (auto& dev : context.joystickDevices)
 					{
-						hwndForDInput = GetConsoleWindow();
+						// Devices beyond the counter table are left closed, like those beyond the fixed device lists on Linux
+						if (!dev.timing.Attach(context.deviceCounters))
+						{
+							continue;
+						}
+
+						hr = context.directInput->CreateDevice(dev.instance.guidInstance, &dev.device, nullptr);
+						if (FAILED(hr))
+						{
+							dev.timing.Detach();
+							continue;
+						}
+
+						hr = dev.device->SetDataFormat(&c_dfDIJoystick2);
+						if (FAILED(hr))
+						{
+							dev.device->Release();
+							dev.device = nullptr;
+							dev.timing.Detach();
+							continue;
+						}
+
+						HWND hwndForDInput = context.cooperativeWnd;
+						if (!hwndForDInput)
+						{
+							hwndForDInput = GetConsoleWindow();
+						}
+						if (!hwndForDInput)
+						{
+							hwndForDInput = GetDesktopWindow();
+						}
+
+						hr = dev.device->SetCooperativeLevel(hwndForDInput, DISCL_BACKGROUND | DISCL_NONEXCLUSIVE);
+						if (FAILED(hr))
+						{
+							dev.device->Release();
+							dev.device = nullptr;
+							dev.timing.Detach();
+							continue;
+						}
+
+						DIPROPRANGE propRange{};
+						propRange.diph.dwSize = sizeof(DIPROPRANGE);
+						propRange.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+						propRange.diph.dwHow = DIPH_BYOFFSET;
+						propRange.lMin = -32768;
+						propRange.lMax = 32767;
+
+						DWORD offsets[] = { DIJOFS_X, DIJOFS_Y, DIJOFS_SLIDER(0), DIJOFS_SLIDER(1) };
+						for (DWORD offset : offsets)
+						{
+							propRange.diph.dwObj = offset;
+							dev.device->SetProperty(DIPROP_RANGE, &propRange.diph);
+						}
+
+						// Without a buffer only the polled state is available and per-event deltas fall back to per-frame
+						DIPROPDWORD propBufferSize{};
+						propBufferSize.diph.dwSize = sizeof(DIPROPDWORD);
+						propBufferSize.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+						propBufferSize.diph.dwHow = DIPH_DEVICE;
+						propBufferSize.diph.dwObj = 0;
+						propBufferSize.dwData = kDeviceDataBufferSize;
+						dev.device->SetProperty(DIPROP_BUFFERSIZE, &propBufferSize.diph);
+
+						// Must be set while unacquired
+						if (context.inputEvent)
+						{
+							dev.device->SetEventNotification(context.inputEvent);
+						}
+
+						dev.device->Acquire();
+						dev.opened = true;
 					}
-					if (!hwndForDInput)
+					context.initializedDevices = context.initializedDevices | DeviceFlags::Joystick;
+				}
+			}
+
+			// Initialize mouse input
+			if ((deviceFlags & DeviceFlags::Mouse) != DeviceFlags::None)
+			{
+				std::string mouseError;
+				if (!InitRawInputWindow(context, &mouseError))
+				{
+					if (pWarningStrings)
 					{
-						hwndForDInput = GetDesktopWindow();
+						pWarningStrings->push_back(mouseError);
 					}
+				}
+				else
+				{
+					context.initializedDevices = context.initializedDevices | DeviceFlags::Mouse;
+				}
+			}
+		}
 
-					hr = dev.device->SetCooperativeLevel(hwndForDInput, DISCL_BACKGROUND | DISCL_NONEXCLUSIVE);
-					if (FAILED(hr))
+		void TerminateDevices(ContextImpl& context, DeviceFlags deviceFlags)
+		{
+			if ((deviceFlags & DeviceFlags::Joystick) != DeviceFlags::None)
+			{
+				for (auto& dev : context.joystickDevices)
+				{
+					if (dev.device)
 					{
+						dev.device->Unacquire();
 						dev.device->Release();
 						dev.device = nullptr;
-						continue;
 					}
+				}
+				context.joystickDevices.clear();
 
-					DIPROPRANGE propRange{};
-					propRange.diph.dwSize = sizeof(DIPROPRANGE);
-					propRange.diph.dwHeaderSize = sizeof(DIPROPHEADER);
-					propRange.diph.dwHow = DIPH_BYOFFSET;
-					propRange.lMin = -32768;
-					propRange.lMax = 32767;
+				if (context.directInput)
+				{
+					context.directInput->Release();
+					context.directInput = nullptr;
+				}
 
-					DWORD offsets[] = { DIJOFS_X, DIJOFS_Y, DIJOFS_SLIDER(0), DIJOFS_SLIDER(1) };
-					for (DWORD offset : offsets)
-					{
-						propRange.diph.dwObj = offset;
-						dev.device->SetProperty(DIPROP_RANGE, &propRange.diph);
-					}
+				if (context.inputEvent)
+				{
+					CloseHandle(context.inputEvent);
+					context.inputEvent = nullptr;
+				}
+			}
+
+			if ((deviceFlags & DeviceFlags::Mouse) != DeviceFlags::None)
+			{
+				TerminateRawInputWindow(context);
+				context.mouseAccumulator = { 0.0, 0.0 };
+			}
 
-					dev.device->Acquire();
-					dev.opened = true;
+			context.initializedDevices = context.initializedDevices & ~deviceFlags;
+		}
+
+		void DrainJoystickDevice(ContextImpl& context, JoystickDevice& dev, UpdateBudgetScope& budget)
+		{
+			if (!dev.opened || !dev.device)
+			{
+				return;
+			}
+
+			KSMAXIS_TRACE_SCOPE(pollTrace, "PollJoystickDevice");
+
+			HRESULT hr = dev.device->Poll();
+			context.counters.AddSyscalls(1);
+			if (FAILED(hr))
+			{
+				hr = dev.device->Acquire();
+				context.counters.AddSyscalls(1);
+				if (FAILED(hr))
+				{
+					return;
 				}
-				s_initializedDevices = s_initializedDevices | DeviceFlags::Joystick;
+				dev.device->Poll();
+				context.counters.AddSyscalls(1);
+			}
+
+			// Resync from the polled state on the first update or when buffered events were lost. The resync has no
+			// timestamp, so its delta lands in the last tick.
+			if (context.firstUpdate || !DrainBufferedJoystickData(dev, context.activeModes, context.counters, budget, context.tickResampler))
+			{
+				FlushBufferedJoystickData(dev, context.counters);
+
+				DIJOYSTATE2 js{};
+				hr = dev.device->GetDeviceState(sizeof(DIJOYSTATE2), &js);
+				context.counters.AddSyscalls(1);
+				if (FAILED(hr))
+				{
+					return;
+				}
+
+				const bool stickActive = context.activeModes.Contains(InputMode::kAnalogStick);
+				const bool sliderActive = context.activeModes.Contains(InputMode::kSlider);
+				ApplyAxisValue(Normalize(js.lX), dev.axisX, dev.deltaAxisX, stickActive);
+				ApplyAxisValue(Normalize(js.lY), dev.axisY, dev.deltaAxisY, stickActive);
+				ApplyAxisValue(Normalize(js.rglSlider[1]), dev.slider0, dev.deltaSlider0, sliderActive); // Intentionally swapped ([0]=right knob, [1]=left knob)
+				ApplyAxisValue(Normalize(js.rglSlider[0]), dev.slider1, dev.deltaSlider1, sliderActive);
+			}
+		}
+
+		// WM_INPUT left in the queue when the budget runs out is dispatched by the next Update()
+		void DrainRawInput(ContextImpl& context, UpdateBudgetScope& budget)
+		{
+			if (!context.hiddenWnd)
+			{
+				return;
+			}
+
+			KSMAXIS_TRACE_SCOPE(rawInputTrace, "DrainRawInput");
+			MSG msg;
+			while (!budget.IsExhausted() && PeekMessageW(&msg, context.hiddenWnd, 0, 0, PM_REMOVE))
+			{
+				TranslateMessage(&msg);
+				DispatchMessageW(&msg);
+				budget.AddEvents(1);
 			}
 		}
 
-		// Initialize mouse input
-		if ((deviceFlags & DeviceFlags::Mouse) != DeviceFlags::None)
+		// Drains the joysticks and then raw input, starting after the source that exhausted the budget last time,
+		// so that a chattering device can't keep the others from being read across truncated Update() calls
+		void DrainInputSources(ContextImpl& context, UpdateBudgetScope& budget)
 		{
-			std::string mouseError;
-			if (!InitRawInputWindow(&mouseError))
+			const std::size_t joystickCount = context.joystickDevices.size();
+			const std::size_t sourceCount = joystickCount + 1;
+
+			for (std::size_t i = 0; i < sourceCount; ++i)
 			{
-				if (pWarningStrings)
+				const std::size_t source = (context.drainStartSource + i) % sourceCount;
+				if (source < joystickCount)
 				{
-					pWarningStrings->push_back(mouseError);
+					DrainJoystickDevice(context, context.joystickDevices[source], budget);
+				}
+				else
+				{
+					DrainRawInput(context, budget);
+				}
+
+				if (budget.WasExhausted())
+				{
+					context.drainStartSource = (source + 1) % sourceCount;
+					return;
 				}
 			}
-			else
+		}
+
+		// Moves the deltas the sources accumulated while being drained into the given sums. Joystick deltas of the
+		// first Update() are dropped, since they are jumps from the initial positions.
+		void CollectDeltas(ContextImpl& context, AxisValues& deltaAnalogStick, AxisValues& deltaSlider, AxisValues& deltaMouse)
+		{
+			deltaMouse[0] += context.mouseAccumulator[0];
+			deltaMouse[1] += context.mouseAccumulator[1];
+			context.mouseAccumulator = { 0.0, 0.0 };
+
+			for (auto& dev : context.joystickDevices)
 			{
-				s_initializedDevices = s_initializedDevices | DeviceFlags::Mouse;
+				if (!context.firstUpdate)
+				{
+					deltaAnalogStick[0] += dev.deltaAxisX;
+					deltaAnalogStick[1] += dev.deltaAxisY;
+					deltaSlider[0] += dev.deltaSlider0;
+					deltaSlider[1] += dev.deltaSlider1;
+				}
+
+				dev.deltaAxisX = 0.0;
+				dev.deltaAxisY = 0.0;
+				dev.deltaSlider0 = 0.0;
+				dev.deltaSlider1 = 0.0;
 			}
 		}
 
-		s_firstUpdate = true;
-		return true;
+		bool WaitForInputEvents(ContextImpl& context, std::uint32_t timeoutMs)
+		{
+			// Raw input posted to the hidden window wakes the wait through QS_RAWINPUT
+			const DWORD handleCount = context.inputEvent ? 1 : 0;
+			const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds{ timeoutMs };
+
+			// Busy-poll while active so that input is picked up without a scheduler wakeup
+			const auto spinDuration = context.capture.GetSpinDuration();
+			if (spinDuration.count() > 0)
+			{
+				const auto spinEnd = (std::min)(deadline, std::chrono::steady_clock::now() + spinDuration);
+				do
+				{
+					if (MsgWaitForMultipleObjectsEx(handleCount, &context.inputEvent, 0, QS_RAWINPUT, MWMO_INPUTAVAILABLE) != WAIT_TIMEOUT)
+					{
+						return true;
+					}
+				} while (std::chrono::steady_clock::now() < spinEnd);
+			}
+
+			const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+			if (remaining.count() <= 0)
+			{
+				return false;
+			}
+
+			const DWORD result = MsgWaitForMultipleObjectsEx(handleCount, &context.inputEvent, static_cast<DWORD>(remaining.count()), QS_RAWINPUT, MWMO_INPUTAVAILABLE);
+			return result != WAIT_TIMEOUT && result != WAIT_FAILED;
+		}
 	}
 
-	bool IsInitialized()
+	Context::Context()
+		: m_pImpl(std::make_unique<ContextImpl>())
 	{
-		return s_initializedDevices != DeviceFlags::None;
 	}
 
-	bool IsInitialized(DeviceFlags deviceFlags)
+	Context::~Context()
 	{
-		return (s_initializedDevices & deviceFlags) == deviceFlags;
+		Terminate();
 	}
 
-	void Terminate()
+	bool Context::Init(DeviceFlags deviceFlags, void* hWnd, std::string* pErrorString, std::vector<std::string>* pWarningStrings)
 	{
-		TerminateRawInputWindow();
+		ContextImpl& context = *m_pImpl;
+		context.requestedDevices = context.requestedDevices | deviceFlags;
+		context.cooperativeWnd = static_cast<HWND>(hWnd);
 
-		for (auto& dev : s_joystickDevices)
+		// Skip already initialized devices, and defer those that no active InputMode needs
+		deviceFlags = deviceFlags & ~context.initializedDevices & context.activeModes.GetRequiredDeviceFlags();
+		if (deviceFlags == DeviceFlags::None)
 		{
-			if (dev.device)
-			{
-				dev.device->Unacquire();
-				dev.device->Release();
-				dev.device = nullptr;
-			}
+			return true;
 		}
-		s_joystickDevices.clear();
 
-		if (s_directInput)
+		KSMAXIS_TRACE_SCOPE(trace, "Init");
+
+		InitDevices(context, deviceFlags, pWarningStrings);
+		return true;
+	}
+
+	void Context::SetActiveInputModes(const std::vector<InputMode>& modes, std::vector<std::string>* pWarningStrings)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.activeModes = InputModeSet::FromList(modes);
+
+		const DeviceFlags requiredDevices = context.activeModes.GetRequiredDeviceFlags();
+		TerminateDevices(context, context.initializedDevices & ~requiredDevices);
+
+		const DeviceFlags deferredDevices = context.requestedDevices & requiredDevices & ~context.initializedDevices;
+		if (deferredDevices != DeviceFlags::None)
 		{
-			s_directInput->Release();
-			s_directInput = nullptr;
+			KSMAXIS_TRACE_SCOPE(trace, "Init");
+			InitDevices(context, deferredDevices, pWarningStrings);
 		}
 
-		s_initializedDevices = DeviceFlags::None;
+		// Don't keep reporting deltas of modes that were just deactivated
+		context.deltaAnalogStick = { 0.0, 0.0 };
+		context.deltaSlider = { 0.0, 0.0 };
+		context.deltaMouse = { 0.0, 0.0 };
+		context.lateDeltas = {};
+		context.lateShaper.Reset();
 	}
 
-	void Update()
+	bool Context::IsInputModeActive(InputMode mode) const
 	{
-		s_deltaAnalogStick = { 0.0, 0.0 };
-		s_deltaSlider = { 0.0, 0.0 };
+		const ContextImpl& context = *m_pImpl;
+		return context.activeModes.Contains(mode);
+	}
 
-		if (s_hiddenWnd)
+	bool Context::IsInitialized() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.initializedDevices != DeviceFlags::None;
+	}
+
+	bool Context::IsInitialized(DeviceFlags deviceFlags) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return (context.initializedDevices & deviceFlags) == deviceFlags;
+	}
+
+	void Context::Terminate()
+	{
+		ContextImpl& context = *m_pImpl;
+		TerminateDevices(context, DeviceFlags::All);
+		context.requestedDevices = DeviceFlags::None;
+	}
+
+	void Context::Update()
+	{
+		ContextImpl& context = *m_pImpl;
+		KSMAXIS_TRACE_SCOPE(trace, "Update");
+		detail::CaptureCpuScope cpuScope{ context.capture, context.counters };
+		detail::UpdateDurationScope durationScope{ context.counters };
+
+		context.deltaAnalogStick = { 0.0, 0.0 };
+		context.deltaSlider = { 0.0, 0.0 };
+		context.deltaMouse = { 0.0, 0.0 };
+		context.lateDeltas = {};
+		context.lateShaper.Reset();
+		context.lastUpdateTruncated = false;
+		context.tickResampler.ClearTicks();
+		context.changeTracker.ClearChangedModes();
+
+		if (context.initializedDevices == DeviceFlags::None)
 		{
-			MSG msg;
-			while (PeekMessageW(&msg, s_hiddenWnd, 0, 0, PM_REMOVE))
-			{
-				TranslateMessage(&msg);
-				DispatchMessageW(&msg);
-			}
+			return;
 		}
 
-		s_deltaMouse = s_mouseAccumulator;
-		s_mouseAccumulator = { 0.0, 0.0 };
+		// Buffered DirectInput records are binned by their timestamps; Raw Input and resyncs land in the last tick
+		if (!context.firstUpdate)
+		{
+			context.tickResampler.BeginFrame(GetMonotonicTimeNs());
+		}
 
-		if (s_initializedDevices == DeviceFlags::None)
+		// The first Update() resyncs every device from its polled state, so it isn't cut short
+		UpdateBudgetScope budget{ context.firstUpdate ? UpdateBudget{} : context.updateBudget };
+		DrainInputSources(context, budget);
+		context.lastUpdateTruncated = budget.WasExhausted();
+		if (context.lastUpdateTruncated)
 		{
-			return;
+			context.counters.AddTruncatedUpdate();
 		}
 
-		for (auto& dev : s_joystickDevices)
+		CollectDeltas(context, context.deltaAnalogStick, context.deltaSlider, context.deltaMouse);
+
+		// Shaped before anything records the deltas, so that every consumer sees the same values
+		const std::array<AxisValues, kInputModeCount> rawDeltas = { context.deltaAnalogStick, context.deltaSlider, context.deltaMouse };
+		context.responseCurves.Apply(InputMode::kAnalogStick, context.deltaAnalogStick);
+		context.responseCurves.Apply(InputMode::kSlider, context.deltaSlider);
+		context.responseCurves.Apply(InputMode::kMouse, context.deltaMouse);
+		context.lateShaper.OnUpdate(rawDeltas, { context.deltaAnalogStick, context.deltaSlider, context.deltaMouse });
+
+		context.axisTotals.Add(InputMode::kAnalogStick, context.deltaAnalogStick);
+		context.axisTotals.Add(InputMode::kSlider, context.deltaSlider);
+		context.axisTotals.Add(InputMode::kMouse, context.deltaMouse);
+		context.tickResampler.EndFrame(rawDeltas, { context.deltaAnalogStick, context.deltaSlider, context.deltaMouse });
+		context.changeTracker.OnUpdate({ context.deltaAnalogStick, context.deltaSlider, context.deltaMouse });
+
+		const bool hadInput = context.changeTracker.GetChangedModes() != 0;
+		context.capture.OnUpdate(hadInput, std::chrono::steady_clock::now());
+
+		context.firstUpdate = false;
+		durationScope.Stop();
+
+		// Last, since a resumed coroutine may read the deltas or await again
+		if (hadInput)
+		{
+			context.inputWaiters.ResumeAll();
+		}
+	}
+
+	std::vector<DeviceInfo> Context::GetDevices() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		std::vector<DeviceInfo> devices;
+
+		for (const auto& dev : context.joystickDevices)
 		{
 			if (!dev.opened || !dev.device)
 			{
 				continue;
 			}
 
-			HRESULT hr = dev.device->Poll();
-			if (FAILED(hr))
-			{
-				hr = dev.device->Acquire();
-				if (FAILED(hr))
-				{
-					continue;
-				}
-				dev.device->Poll();
-			}
+			DeviceInfo& info = devices.emplace_back();
+			info.name = WideToUtf8(dev.instance.tszProductName);
 
-			DIJOYSTATE2 js{};
-			hr = dev.device->GetDeviceState(sizeof(DIJOYSTATE2), &js);
-			if (FAILED(hr))
+			wchar_t guidString[64] = {};
+			if (StringFromGUID2(dev.instance.guidInstance, guidString, static_cast<int>(std::size(guidString))) > 0)
 			{
-				continue;
+				info.path = WideToUtf8(guidString);
 			}
 
-			dev.axisX = Normalize(js.lX);
-			dev.axisY = Normalize(js.lY);
-			dev.slider0 = Normalize(js.rglSlider[1]); // Intentionally swapped ([0]=right knob, [1]=left knob)
-			dev.slider1 = Normalize(js.rglSlider[0]);
+			info.id = dev.timing.GetDeviceId();
+			info.backend = "DirectInput";
+
+			// For HID devices the product GUID starts with MAKELONG(vendorId, productId)
+			info.vendorId = LOWORD(dev.instance.guidProduct.Data1);
+			info.productId = HIWORD(dev.instance.guidProduct.Data1);
 
-			if (!s_firstUpdate)
+			// Slider order matches the intentional swap in Update()
+			const DWORD offsets[] = { DIJOFS_X, DIJOFS_Y, DIJOFS_SLIDER(1), DIJOFS_SLIDER(0) };
+			for (std::size_t i = 0; i < info.axes.size(); ++i)
 			{
-				s_deltaAnalogStick[0] += CalculateDelta(dev.axisX, dev.prevAxisX);
-				s_deltaAnalogStick[1] += CalculateDelta(dev.axisY, dev.prevAxisY);
-				s_deltaSlider[0] += CalculateDelta(dev.slider0, dev.prevSlider0);
-				s_deltaSlider[1] += CalculateDelta(dev.slider1, dev.prevSlider1);
+				DIPROPRANGE propRange{};
+				propRange.diph.dwSize = sizeof(DIPROPRANGE);
+				propRange.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+				propRange.diph.dwHow = DIPH_BYOFFSET;
+				propRange.diph.dwObj = offsets[i];
+				if (SUCCEEDED(dev.device->GetProperty(DIPROP_RANGE, &propRange.diph)))
+				{
+					info.axes[i] = DeviceAxisInfo{ true, propRange.lMin, propRange.lMax };
+				}
 			}
 
-			dev.prevAxisX = dev.axisX;
-			dev.prevAxisY = dev.axisY;
-			dev.prevSlider0 = dev.slider0;
-			dev.prevSlider1 = dev.slider1;
+			info.stats = dev.timing.Summarize();
+		}
+
+		return devices;
+	}
+
+	void Context::ResetDeviceStats()
+	{
+		ContextImpl& context = *m_pImpl;
+		for (auto& dev : context.joystickDevices)
+		{
+			dev.timing.Reset();
+		}
+	}
+
+	bool Context::WaitForInput(std::uint32_t timeoutMs)
+	{
+		ContextImpl& context = *m_pImpl;
+		KSMAXIS_TRACE_SCOPE(trace, "WaitForInput");
+		detail::CaptureCpuScope cpuScope{ context.capture, context.counters };
+
+		const bool ready = WaitForInputEvents(context, timeoutMs);
+		context.capture.AddWakeup();
+
+		KSMAXIS_TRACE_ARG(trace, "ready", ready);
+		return ready;
+	}
+
+	void Context::LatchLateInput()
+	{
+		ContextImpl& context = *m_pImpl;
+		KSMAXIS_TRACE_SCOPE(trace, "LatchLateInput");
+		detail::CaptureCpuScope cpuScope{ context.capture, context.counters };
+
+		// The first Update() resyncs the devices, so there is nothing to latch before it
+		if (context.initializedDevices == DeviceFlags::None || context.firstUpdate)
+		{
+			return;
+		}
+
+		UpdateBudgetScope budget{ context.updateBudget };
+		DrainInputSources(context, budget);
+
+		std::array<AxisValues, kInputModeCount> deltas{};
+		CollectDeltas(context, deltas[0], deltas[1], deltas[2]);
+		context.lateShaper.Shape(context.responseCurves, deltas);
+		for (std::size_t i = 0; i < kInputModeCount; ++i)
+		{
+			const InputMode mode = static_cast<InputMode>(i);
+			context.axisTotals.Add(mode, deltas[i]);
+			context.lateDeltas[i][0] += deltas[i][0];
+			context.lateDeltas[i][1] += deltas[i][1];
 		}
+		context.changeTracker.OnLateInput(deltas);
+	}
+
+	AxisValues Context::GetLateAxisDeltas(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.lateDeltas[static_cast<std::size_t>(mode)];
+	}
 
-		s_firstUpdate = false;
+	void Context::SetUpdateBudget(const UpdateBudget& budget)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.updateBudget = budget;
+	}
+
+	UpdateBudget Context::GetUpdateBudget() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.updateBudget;
+	}
+
+	bool Context::WasUpdateTruncated() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.lastUpdateTruncated;
+	}
+
+	UpdateStats Context::GetUpdateStats() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.counters.GetStats();
+	}
+
+	void Context::ResetUpdateStats()
+	{
+		ContextImpl& context = *m_pImpl;
+		context.counters.Reset();
+	}
+
+	std::size_t Context::GetDeviceCounters(std::span<DeviceCounters> counters) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.deviceCounters.Read(counters);
+	}
+
+	void* Context::GetWaitHandle() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.inputEvent;
+	}
+
+	void Context::AddInputWaiter(std::coroutine_handle<> handle)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.inputWaiters.Add(handle);
+	}
+
+	void Context::SetCapturePolicy(const CapturePolicy& policy)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.capture.SetPolicy(policy);
+	}
+
+	CapturePolicy Context::GetCapturePolicy() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.capture.GetPolicy();
 	}
 
-	AxisValues GetAxisDeltas(InputMode mode)
+	CaptureState Context::GetCaptureState() const
 	{
+		const ContextImpl& context = *m_pImpl;
+		return context.capture.GetState();
+	}
+
+	CaptureStats Context::GetCaptureStats() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.capture.GetStats();
+	}
+
+	void Context::ResetCaptureStats()
+	{
+		ContextImpl& context = *m_pImpl;
+		context.capture.ResetStats();
+	}
+
+	AxisValues Context::GetAxisDeltas(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
 		if (mode == InputMode::kAnalogStick)
 		{
-			return s_deltaAnalogStick;
+			return context.deltaAnalogStick;
 		}
 		else if (mode == InputMode::kMouse)
 		{
-			return s_deltaMouse;
+			return context.deltaMouse;
 		}
 		else
 		{
-			return s_deltaSlider;
+			return context.deltaSlider;
+		}
+	}
+
+	AxisValues Context::GetAxisTotals(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.axisTotals.Get(mode);
+	}
+
+	std::uint32_t Context::GetChangedModes() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.changeTracker.GetChangedModes();
+	}
+
+	std::uint64_t Context::GetChangeGeneration() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.changeTracker.GetGeneration();
+	}
+
+	std::uint64_t Context::GetChangeGeneration(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.changeTracker.GetGeneration(mode);
+	}
+
+	bool Context::SetResponseCurve(InputMode mode, const ResponseCurve& curve, std::string* pErrorString)
+	{
+		ContextImpl& context = *m_pImpl;
+		ResponseCurveTable table;
+		if (!CompileResponseCurve(curve, table, pErrorString))
+		{
+			return false;
 		}
+		context.responseCurves.Set(mode, table);
+		return true;
+	}
+
+	void Context::SetResponseCurve(InputMode mode, const ResponseCurveTable& table)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.responseCurves.Set(mode, table);
+	}
+
+	void Context::ClearResponseCurve(InputMode mode)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.responseCurves.Clear(mode);
+	}
+
+	void Context::SetTickInterval(std::uint32_t tickUs)
+	{
+		ContextImpl& context = *m_pImpl;
+		context.tickResampler.SetTickInterval(tickUs);
+	}
+
+	std::span<const AxisValues> Context::GetTickDeltas(InputMode mode) const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.tickResampler.GetTicks(mode);
+	}
+
+	std::int64_t Context::GetFirstTickTimeNs() const
+	{
+		const ContextImpl& context = *m_pImpl;
+		return context.tickResampler.GetFirstTickTimeNs();
 	}
 }
 
@@ -0,0 +1,149 @@
+// Replays evdev packets of a knob spun several turns between two Update() calls through ProcessJoystickEvent(),
+// the same path as the Linux backend (EV_ABS staging, SYN_REPORT commit, EVIOCGABS seeding and normalization),
+// and checks that the summed frame delta equals the true rotation at several polling rates.
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "ksmaxis_evdev.hpp"
+
+namespace
+{
+	constexpr double kReportRateHz = 1000.0;
+	constexpr double kReplaySeconds = 2.0;
+
+	struct SpinCase
+	{
+		std::int32_t min;
+		std::int32_t max; // max - min + 1 positions per turn; max and min are neighbours
+		std::int64_t startPosition; // Seeded through EVIOCGABS
+		std::int64_t stepsPerReport; // Knob speed; its sign is the direction
+	};
+
+	std::int64_t FloorDiv(std::int64_t a, std::int64_t b)
+	{
+		return a / b - ((a % b != 0) && ((a < 0) != (b < 0)) ? 1 : 0);
+	}
+
+	std::int32_t ToRawValue(const SpinCase& spin, std::int64_t position)
+	{
+		const std::int64_t positionCount = spin.max - spin.min + 1;
+		return static_cast<std::int32_t>(spin.min + (position - FloorDiv(position, positionCount) * positionCount));
+	}
+
+	// Expected rotation in normalized units: whole turns, plus the change of the normalized position within a turn.
+	// Per report, the knob is seen taking the shorter way around, so a step past half a turn reads as the rest of
+	// the turn in the other direction.
+	double ExpectedRotation(const SpinCase& spin, std::int64_t reportCount)
+	{
+		const std::int64_t positionCount = spin.max - spin.min + 1;
+		std::int64_t step = spin.stepsPerReport % positionCount;
+		if (2 * step > positionCount)
+		{
+			step -= positionCount;
+		}
+		else if (2 * step < -positionCount)
+		{
+			step += positionCount;
+		}
+
+		const std::int64_t endPosition = spin.startPosition + step * reportCount;
+		const double range = static_cast<double>(spin.max - spin.min);
+		const double startValue = (ToRawValue(spin, spin.startPosition) - spin.min) / range;
+		const double endValue = (ToRawValue(spin, endPosition) - spin.min) / range;
+		const std::int64_t turns = FloorDiv(endPosition, positionCount) - FloorDiv(spin.startPosition, positionCount);
+		return static_cast<double>(turns) + endValue - startValue;
+	}
+
+	input_event MakeEvent(std::uint16_t type, std::uint16_t code, std::int32_t value, std::int64_t timeUs)
+	{
+		input_event ev{};
+		ev.input_event_sec = static_cast<decltype(ev.input_event_sec)>(timeUs / 1000000);
+		ev.input_event_usec = static_cast<decltype(ev.input_event_usec)>(timeUs % 1000000);
+		ev.type = type;
+		ev.code = code;
+		ev.value = value;
+		return ev;
+	}
+
+	// Returns the sum of the deltas each Update() collects. ABS_X spins forward and ABS_RUDDER backward, in the
+	// same packets.
+	ksmaxis::AxisValues ReplaySpin(const SpinCase& spin, double pollingRateHz)
+	{
+		using namespace ksmaxis::detail;
+
+		EvdevKnobState knobs;
+		for (const int code : { ABS_X, ABS_RUDDER })
+		{
+			knobs.ranges[code] = { spin.min, spin.max, true };
+		}
+		knobs.monotonicTimestamps = true;
+
+		std::int32_t initialValues[ABS_CNT] = {};
+		initialValues[ABS_X] = ToRawValue(spin, spin.startPosition);
+		initialValues[ABS_RUDDER] = ToRawValue(spin, -spin.startPosition);
+		SeedEvdevKnobAxes(knobs, initialValues);
+
+		DeviceTimingAccumulator timing;
+		TickResampler resampler;
+		const InputModeSet modes = InputModeSet::All();
+
+		const auto reportCount = static_cast<std::int64_t>(kReplaySeconds * kReportRateHz);
+		const auto reportsPerUpdate = static_cast<std::int64_t>(kReportRateHz / pollingRateHz);
+		ksmaxis::AxisValues summed = { 0.0, 0.0 };
+		std::int64_t position = spin.startPosition;
+		for (std::int64_t i = 1; i <= reportCount; ++i)
+		{
+			position += spin.stepsPerReport;
+			const std::int64_t timeUs = i * static_cast<std::int64_t>(1000000 / kReportRateHz);
+			ProcessJoystickEvent(knobs, timing, MakeEvent(EV_ABS, ABS_X, ToRawValue(spin, position), timeUs), 0, modes, resampler);
+			ProcessJoystickEvent(knobs, timing, MakeEvent(EV_ABS, ABS_RUDDER, ToRawValue(spin, -position), timeUs), 0, modes, resampler);
+			ProcessJoystickEvent(knobs, timing, MakeEvent(EV_SYN, SYN_REPORT, 0, timeUs), timeUs * 1000, modes, resampler);
+
+			// Update(): collect the accumulated deltas
+			if (i % reportsPerUpdate == 0 || i == reportCount)
+			{
+				summed[0] += knobs.deltaAxisX;
+				summed[1] += knobs.deltaSlider1;
+				knobs.deltaAxisX = 0.0;
+				knobs.deltaSlider1 = 0.0;
+			}
+		}
+		return summed;
+	}
+}
+
+int main()
+{
+	constexpr SpinCase kSpinCases[] = {
+		{ 0, 1023, 0, 37 }, // About 36 turns per second, i.e. several turns per frame at low polling rates
+		{ 0, 1023, 700, -37 },
+		{ 0, 255, 200, 100 },
+		{ -512, 511, -100, 300 },
+		{ 0, 255, 50, 160 }, // Past half a turn per report: reads as 96 steps backward
+		{ 0, 255, 50, -200 }, // Reads as 56 steps forward
+	};
+	constexpr double kPollingRatesHz[] = { 4.0, 10.0, 30.0, 60.0, 144.0, 1000.0 };
+
+	const auto reportCount = static_cast<std::int64_t>(kReplaySeconds * kReportRateHz);
+	int failureCount = 0;
+	for (const SpinCase& spin : kSpinCases)
+	{
+		const double expectedForward = ExpectedRotation(spin, reportCount);
+		const double expectedBackward = ExpectedRotation({ spin.min, spin.max, -spin.startPosition, -spin.stepsPerReport }, reportCount);
+		for (double pollingRateHz : kPollingRatesHz)
+		{
+			const ksmaxis::AxisValues summed = ReplaySpin(spin, pollingRateHz);
+			const bool passed = std::abs(summed[0] - expectedForward) < 1e-6 && std::abs(summed[1] - expectedBackward) < 1e-6;
+			std::printf("%s: range %d~%d, %+lld steps/report, %6.1f Hz polling: summed %+.6f/%+.6f turns, expected %+.6f/%+.6f turns\n",
+				passed ? "OK" : "FAILED", spin.min, spin.max, static_cast<long long>(spin.stepsPerReport), pollingRateHz, summed[0], summed[1], expectedForward, expectedBackward);
+			if (!passed)
+			{
+				++failureCount;
+			}
+		}
+	}
+
+	return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
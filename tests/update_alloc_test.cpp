@@ -0,0 +1,258 @@
+// Checks the claim of Context::Update() that it performs no heap allocations of its own once initialized, including
+// the hotplug rescan. Global operator new is replaced with a counting version; the warm-up calls may allocate,
+// the measured calls must not. A uinput knob device is plugged in and out during the measured calls, so that they
+// include rescans that open and close a device; without it (no writable /dev/uinput, or not Linux) the test only
+// covers idle calls and reports itself as skipped (exit code 77).
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/uinput.h>
+#endif
+
+#include "ksmaxis/ksmaxis.hpp"
+
+namespace
+{
+	constexpr int kSkipExitCode = 77;
+
+	std::atomic<bool> s_counting{ false };
+	std::atomic<std::size_t> s_allocationCount{ 0 };
+
+	void* Allocate(std::size_t size, std::size_t alignment)
+	{
+		if (s_counting.load(std::memory_order_relaxed))
+		{
+			s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (size == 0)
+		{
+			size = 1;
+		}
+#ifdef _WIN32
+		void* ptr = _aligned_malloc(size, alignment);
+#else
+		void* ptr = alignment > alignof(std::max_align_t) ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment) : std::malloc(size);
+#endif
+		if (!ptr)
+		{
+			throw std::bad_alloc();
+		}
+		return ptr;
+	}
+
+	void Deallocate(void* ptr) noexcept
+	{
+#ifdef _WIN32
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+
+#ifdef __linux__
+	// A virtual device with the axes of a knob controller, or -1 if uinput is unavailable
+	int CreateUinputKnobDevice()
+	{
+		const int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+		if (fd < 0)
+		{
+			return -1;
+		}
+
+		// A button makes udev classify it as a joystick
+		ioctl(fd, UI_SET_EVBIT, EV_KEY);
+		ioctl(fd, UI_SET_KEYBIT, BTN_TRIGGER);
+		ioctl(fd, UI_SET_EVBIT, EV_ABS);
+		ioctl(fd, UI_SET_ABSBIT, ABS_X);
+		ioctl(fd, UI_SET_ABSBIT, ABS_Y);
+
+		uinput_user_dev dev{};
+		std::snprintf(dev.name, sizeof(dev.name), "ksmaxis test knobs");
+		dev.id.bustype = BUS_VIRTUAL;
+		dev.id.vendor = 0x1234;
+		dev.id.product = 0x5678;
+		dev.absmax[ABS_X] = 255;
+		dev.absmax[ABS_Y] = 255;
+		if (write(fd, &dev, sizeof(dev)) != static_cast<ssize_t>(sizeof(dev)) || ioctl(fd, UI_DEV_CREATE) < 0)
+		{
+			close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	void WriteUinputKnobEvent(int fd, int value)
+	{
+		input_event events[2]{};
+		events[0].type = EV_ABS;
+		events[0].code = ABS_X;
+		events[0].value = value;
+		events[1].type = EV_SYN;
+		events[1].code = SYN_REPORT;
+		[[maybe_unused]] const ssize_t size = write(fd, events, sizeof(events));
+	}
+
+	void DestroyUinputKnobDevice(int fd)
+	{
+		ioctl(fd, UI_DEV_DESTROY);
+		close(fd);
+	}
+#endif
+
+	std::size_t GetDeviceCount(const ksmaxis::Context& context)
+	{
+		ksmaxis::DeviceCounters counters[64];
+		return context.GetDeviceCounters(counters);
+	}
+
+	// Plugs a knob device in, turns it and unplugs it again, with Update() calls in between. Returns whether
+	// Update() opened the device.
+	bool RunHotplugCycle(ksmaxis::Context& context, bool count)
+	{
+		bool opened = false;
+		const auto update = [&]
+		{
+			s_counting.store(count, std::memory_order_relaxed);
+			context.Update();
+			s_counting.store(false, std::memory_order_relaxed);
+		};
+
+#ifdef __linux__
+		const int fd = CreateUinputKnobDevice();
+		if (fd >= 0)
+		{
+			// udev needs a moment to create the node
+			const std::size_t deviceCount = GetDeviceCount(context);
+			usleep(200000);
+			update();
+			opened = GetDeviceCount(context) > deviceCount;
+			for (int i = 0; i < 32; ++i)
+			{
+				WriteUinputKnobEvent(fd, (i * 37) % 256);
+				update();
+			}
+			DestroyUinputKnobDevice(fd);
+			usleep(200000);
+		}
+#endif
+		for (int i = 0; i < 8; ++i)
+		{
+			update();
+		}
+		return opened;
+	}
+}
+
+void* operator new(std::size_t size)
+{
+	return Allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size)
+{
+	return Allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	return Allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return Allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept
+{
+	Deallocate(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	Deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	Deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	Deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+	Deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept
+{
+	Deallocate(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	Deallocate(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept
+{
+	Deallocate(ptr);
+}
+
+int main()
+{
+	ksmaxis::Context context;
+
+	// Rescan on every Update(), so that the measured calls include rescans
+	ksmaxis::CapturePolicy policy = context.GetCapturePolicy();
+	policy.activeRescanIntervalMs = 0;
+	policy.idleRescanIntervalMs = 0;
+	context.SetCapturePolicy(policy);
+
+	std::string errorString;
+	std::vector<std::string> warningStrings;
+	context.Init(ksmaxis::DeviceFlags::Joystick | ksmaxis::DeviceFlags::Mouse, &errorString, &warningStrings);
+	for (const auto& warning : warningStrings)
+	{
+		std::printf("warning: %s\n", warning.c_str());
+	}
+
+	// Warm-up: first Update(), first rescans and the first hotplug may allocate
+	RunHotplugCycle(context, false);
+
+	s_allocationCount.store(0);
+	bool hotplugCovered = RunHotplugCycle(context, true);
+	hotplugCovered = RunHotplugCycle(context, true) && hotplugCovered;
+
+	const std::size_t allocationCount = s_allocationCount.load();
+	context.Terminate();
+
+	if (allocationCount != 0)
+	{
+		std::printf("FAILED: Update() allocated %zu times after warm-up\n", allocationCount);
+		return EXIT_FAILURE;
+	}
+	if (!hotplugCovered)
+	{
+		std::printf("SKIPPED: no allocations in idle Update() calls, but no uinput device was hotplugged (needs a writable /dev/uinput)\n");
+		return kSkipExitCode;
+	}
+	std::printf("OK: no allocations in Update() after warm-up, including hotplug rescans\n");
+	return EXIT_SUCCESS;
+}
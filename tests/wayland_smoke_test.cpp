@@ -0,0 +1,111 @@
+// Runs Update() with DeviceFlags::Mouse read from Wayland relative pointer events on a real compositor (e.g. a
+// headless weston), checking that the connection survives Init(), dispatch and Terminate(). Skipped (exit code 77)
+// without WAYLAND_DISPLAY.
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <wayland-client.h>
+
+#include "ksmaxis/ksmaxis.hpp"
+
+namespace
+{
+	constexpr int kSkipExitCode = 77;
+
+	wl_compositor* s_compositor = nullptr;
+
+	void OnRegistryGlobal(void*, wl_registry* registry, std::uint32_t name, const char* interfaceName, std::uint32_t)
+	{
+		if (std::strcmp(interfaceName, wl_compositor_interface.name) == 0)
+		{
+			s_compositor = static_cast<wl_compositor*>(wl_registry_bind(registry, name, &wl_compositor_interface, 1));
+		}
+	}
+
+	void OnRegistryGlobalRemove(void*, wl_registry*, std::uint32_t)
+	{
+	}
+
+	constexpr wl_registry_listener kRegistryListener = {
+		.global = OnRegistryGlobal,
+		.global_remove = OnRegistryGlobalRemove,
+	};
+}
+
+int main()
+{
+	if (!std::getenv("WAYLAND_DISPLAY"))
+	{
+		std::printf("WAYLAND_DISPLAY is not set; skipped\n");
+		return kSkipExitCode;
+	}
+
+	// Without X11, a failing Wayland backend can't be masked by the X11 fallback
+	unsetenv("DISPLAY");
+
+	wl_display* display = wl_display_connect(nullptr);
+	if (!display)
+	{
+		std::printf("FAILED: could not connect to the Wayland display\n");
+		return EXIT_FAILURE;
+	}
+
+	wl_registry* registry = wl_display_get_registry(display);
+	wl_registry_add_listener(registry, &kRegistryListener, nullptr);
+	wl_display_roundtrip(display);
+	if (!s_compositor)
+	{
+		std::printf("FAILED: no wl_compositor\n");
+		return EXIT_FAILURE;
+	}
+	wl_surface* surface = wl_compositor_create_surface(s_compositor);
+
+	int result = EXIT_SUCCESS;
+	{
+		ksmaxis::Context context;
+		context.SetWaylandSurface(display, surface);
+
+		std::string errorString;
+		std::vector<std::string> warningStrings;
+		const bool initialized = context.Init(ksmaxis::DeviceFlags::Mouse, &errorString, &warningStrings);
+		for (const auto& warning : warningStrings)
+		{
+			std::printf("warning: %s\n", warning.c_str());
+		}
+		if (!initialized)
+		{
+			std::printf("FAILED: Init(DeviceFlags::Mouse): %s\n", errorString.c_str());
+			result = EXIT_FAILURE;
+		}
+
+		for (int i = 0; i < 16 && result == EXIT_SUCCESS; ++i)
+		{
+			context.Update();
+			wl_display_roundtrip(display);
+		}
+
+		context.Terminate();
+	}
+
+	// The application's connection must still be usable after the library is done with it
+	if (wl_display_roundtrip(display) < 0)
+	{
+		std::printf("FAILED: Wayland connection broken after Terminate()\n");
+		result = EXIT_FAILURE;
+	}
+
+	wl_surface_destroy(surface);
+	wl_compositor_destroy(s_compositor);
+	wl_registry_destroy(registry);
+	wl_display_disconnect(display);
+
+	if (result == EXIT_SUCCESS)
+	{
+		std::printf("OK\n");
+	}
+	return result;
+}